@@ -0,0 +1,112 @@
+/** @file Checkpoint.cpp
+	@brief Background saving of checkpoint files (see Checkpoint.h)
+*/
+
+#include "Checkpoint.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <utility>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+/** Flushes the contents of a file to disk (what any stream wrote to it, once that stream was flushed)
+	@param file path
+	@return false if the file could not be synced (true on systems without fsync, where this does nothing)
+*/
+bool sync_file(const std::string& file) {
+#if defined(__unix__) || defined(__APPLE__)
+	int descriptor = open(file.c_str(), O_RDONLY);
+	if (descriptor < 0) {
+		return false;
+	}
+	bool synced = (fsync(descriptor) == 0);
+	close(descriptor);
+	return synced;
+#else
+	(void)file;
+	return true;
+#endif
+}
+
+}
+
+/** Constructor of CheckpointWriter
+	@param path checkpoint file (replaced by each save)
+	@param output file whose position the checkpoints record, synced to disk before each checkpoint is put in
+	place ("": none); the caller flushes its stream before calling save
+*/
+CheckpointWriter::CheckpointWriter(const std::string& path, const std::string& output) : path(path), output(output), failed(false) {
+}
+
+/** Destructor: the last save is completed before the writer goes away
+*/
+CheckpointWriter::~CheckpointWriter() {
+	wait();
+}
+
+/** Returns true while a save is in progress
+*/
+bool CheckpointWriter::busy() const {
+	return pending.valid() && pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+/** Starts saving in the background (waits first if the previous save is still in progress)
+	@param contents writes the checkpoint; it must own the state it writes
+*/
+void CheckpointWriter::save(std::function<void(std::ostream&)> contents) {
+	wait();
+	std::string file = path, synced = output;
+	pending = std::async(std::launch::async, [file, synced](const std::function<void(std::ostream&)>& write) {
+		std::string temporary = file + ".tmp";
+		{
+			std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+			write(out);
+			out.flush();
+			if (!out) {
+				return false;
+			}
+		}
+		if (!sync_file(temporary) || (!synced.empty() && !sync_file(synced))) { // both on disk before the rename
+			return false;
+		}
+		if (std::rename(temporary.c_str(), file.c_str()) != 0) { // some systems do not rename over a file
+			std::remove(file.c_str());
+			return std::rename(temporary.c_str(), file.c_str()) == 0;
+		}
+		return true;
+	}, std::move(contents));
+}
+
+/** Waits for the save in progress
+	@return false if this save or an earlier one failed
+*/
+bool CheckpointWriter::wait() {
+	if (pending.valid() && !pending.get()) {
+		failed = true;
+	}
+	return !failed;
+}
+
+/** Writes one 64-bit word (in the byte order of the machine)
+	@param out destination
+	@param word value
+*/
+void write_word(std::ostream& out, std::uint64_t word) {
+	out.write(reinterpret_cast<const char*>(&word), sizeof(word));
+}
+
+/** Reads one 64-bit word written by write_word
+	@param in source
+	@param word receives the value
+	@return false if the file ended (or could not be read)
+*/
+bool read_word(std::istream& in, std::uint64_t& word) {
+	return (bool)in.read(reinterpret_cast<char*>(&word), sizeof(word));
+}
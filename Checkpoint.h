@@ -0,0 +1,48 @@
+/** @file Checkpoint.h
+	@brief Background saving of checkpoint files, used by the table generator to resume interrupted jobs
+
+	A save writes the new contents to <path>.tmp on a background thread and then renames it over <path>, so the
+	file at <path> is always either the previous checkpoint or the new one, never a partly written file. Before
+	the rename, the new contents and the output file that the checkpoint refers to (if one is given) are synced
+	to disk (fsync, on POSIX systems), so that after a crash the checkpoint never records an output position that
+	the output file on disk has not reached. The
+	contents are produced by a function that owns a copy of the state, so the caller can keep computing while it
+	is written. Words are stored in the byte order of the machine: a checkpoint is read back on the same kind of
+	machine that wrote it.
+*/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <iosfwd>
+#include <string>
+
+/** @class CheckpointWriter
+	@brief Replaces one checkpoint file, one save at a time, in the background
+*/
+class CheckpointWriter {
+public:
+	explicit CheckpointWriter(const std::string& path, const std::string& output = std::string()); // output: synced before each rename ("": none)
+	~CheckpointWriter(); // Waits for the save in progress
+
+	CheckpointWriter(const CheckpointWriter&) = delete;
+	CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+	bool busy() const;											// True while a save is in progress
+	void save(std::function<void(std::ostream&)> contents);	// Starts a save (after waiting for the previous one)
+	bool wait();												// Waits for the save in progress; false if any save failed
+
+private:
+	std::string path;
+	std::string output; // file that the checkpoints refer to ("": none)
+	std::future<bool> pending; // the save in progress (true if it succeeded)
+	bool failed;
+};
+
+void write_word(std::ostream& out, std::uint64_t word); // Writes one 64-bit word
+bool read_word(std::istream& in, std::uint64_t& word);  // Reads one 64-bit word (false at the end of the file)
+
+#endif //Ends the include guard
@@ -0,0 +1,457 @@
+/** @file DecimalInteger.cpp
+	@brief Integer values stored in base 10^19 (see DecimalInteger.h)
+
+Each limb is below 10^19 < 2^64, and the carries are taken against 10^19 instead of 2^64. A multiply-by-limb
+step produces a 128-bit value, which is split into quotient and remainder by 10^19 with a precomputed
+reciprocal (Moller and Granlund's 2/1 division; 10^19 > 2^63 is already normalized), so the inner loops
+never call a division routine.
+*/
+
+#include "DecimalInteger.h"
+#include "IntegerInternal.h"
+#include <iostream>
+#include <string>
+#include <utility>
+
+typedef DecimalInteger::limb limb;
+typedef unsigned __int128 dlimb; // Holds the product of two limbs
+
+namespace {
+
+const limb base = DecimalInteger::base;
+const limb base_inverse = (limb)(~(dlimb)0 / base); // floor((2^128 - 1)/10^19) - 2^64 (the 2^64 wraps away)
+
+/** Divides t by 10^19, where t < 10^19 * 2^64
+	@param t dividend
+	@param remainder receives t % 10^19
+	@return t / 10^19
+*/
+inline limb divide_base(dlimb t, limb& remainder) {
+	limb high = (limb)(t >> 64), low = (limb)t;
+	dlimb q = (dlimb)base_inverse * high + t;
+	limb q1 = (limb)(q >> 64) + 1, q0 = (limb)q;
+	limb r = low - q1 * base;
+	if (r > q0) {
+		--q1;
+		r += base;
+	}
+	if (r >= base) {
+		++q1;
+		r -= base;
+	}
+	remainder = r;
+	return q1;
+}
+
+/** r = a + b (base 10^19) over n limbs (r may alias a or b)
+	@return the carry out of the top limb
+*/
+limb add_n(limb* r, const limb* a, const limb* b, std::size_t n) {
+	limb carry = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		limb t = b[i] + carry; // at most 10^19, no wrap
+		limb s = a[i] + t;
+		if (s < a[i] || s >= base) { // the true sum is at least 10^19 (it may have wrapped past 2^64)
+			s -= base;
+			carry = 1;
+		}
+		else {
+			carry = 0;
+		}
+		r[i] = s;
+	}
+	return carry;
+}
+
+/** r = a - b (base 10^19) over n limbs (r may alias a or b)
+	@return the borrow out of the top limb
+*/
+limb sub_n(limb* r, const limb* a, const limb* b, std::size_t n) {
+	limb borrow = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		limb t = b[i] + borrow;
+		if (a[i] >= t) {
+			r[i] = a[i] - t;
+			borrow = 0;
+		}
+		else {
+			r[i] = a[i] + (base - t);
+			borrow = 1;
+		}
+	}
+	return borrow;
+}
+
+/** r = r + a*b (base 10^19) over n limbs
+	@return the limb carried out of r[n-1]
+*/
+limb addmul_1(limb* r, const limb* a, std::size_t n, limb b) {
+	limb carry = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		carry = divide_base((dlimb)a[i] * b + r[i] + carry, r[i]);
+	}
+	return carry;
+}
+
+/** @class DecimalLimbs
+	@brief Limb arithmetic in base 10^19 for add_signed (see IntegerInternal.h)
+*/
+struct DecimalLimbs {
+	static limb add_n(limb* r, const limb* a, const limb* b, std::size_t n) { return ::add_n(r, a, b, n); }
+	static limb sub_n(limb* r, const limb* a, const limb* b, std::size_t n) { return ::sub_n(r, a, b, n); }
+	static limb add_1(limb& r, limb a, limb carry) { // r = a + carry, returns the carry
+		r = a + carry;
+		if (r == base) {
+			r = 0;
+			return 1;
+		}
+		return 0;
+	}
+	static limb sub_1(limb& r, limb a, limb borrow) { // r = a - borrow, returns the borrow
+		if (a < borrow) {
+			r = base - 1;
+			return 1;
+		}
+		r = a - borrow;
+		return 0;
+	}
+};
+
+}
+
+/** Output operator <<
+	@param out allows std::cout, etc output types
+	@param d accepts a DecimalInteger type output
+	@return out so that << can be called consecutively
+*/
+std::ostream& operator<<(std::ostream& out, const DecimalInteger& d) {
+	d.print_as_int(out);
+	return out;
+}
+
+/** Writes value in binary: one word holding (number of limbs)*2 + sign, then the limbs (in the byte order of the machine)
+	@param out destination (opened in binary mode)
+	@param value the value to write
+*/
+void write_binary(std::ostream& out, const DecimalInteger& value) {
+	limb header = (limb)value.mag.size() * 2 + value.sign;
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(value.mag.data()), (std::streamsize)(value.mag.size() * sizeof(limb)));
+}
+
+/** Reads a value written by write_binary
+	@param in source (opened in binary mode)
+	@param value receives the value
+	@return false if the input ended too early or is not a valid value
+*/
+bool read_binary(std::istream& in, DecimalInteger& value) {
+	limb header;
+	if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+		return false;
+	}
+	value.mag.resize((std::size_t)(header / 2));
+	value.sign = (header & 1) != 0;
+	if (!in.read(reinterpret_cast<char*>(value.mag.data()), (std::streamsize)(value.mag.size() * sizeof(limb)))) {
+		return false;
+	}
+	return (value.mag.empty() && !value.sign) || (!value.mag.empty() && value.mag.back() != 0 && value.mag.back() < DecimalInteger::base);
+}
+
+/** Default constructor of DecimalInteger class
+*/
+DecimalInteger::DecimalInteger() : sign(0) {
+}
+
+/** Constructor of DecimalInteger class with parameter
+	@param a is an integer (|a| < 10^19, so it fits in one limb)
+*/
+DecimalInteger::DecimalInteger(int a) {
+	long long value = a; // widened so that -INT_MIN is representable
+	sign = (value < 0);
+	if (value < 0) {
+		value = -value;
+	}
+	if (value != 0) {
+		mag.push_back((limb)value);
+	}
+}
+
+/** Converts an Integer to base 10^19 (by repeated division, quadratic in the length)
+	@param a the value to convert
+*/
+DecimalInteger::DecimalInteger(const Integer& a) : sign(a < 0) {
+	Integer quotient = a.abs();
+	while (quotient.size() != 0) {
+		mag.push_back(quotient.divide_limb(base));
+	}
+}
+
+/** Copies the value of other into the storage of lhs (the same as the copy assignment; see Integer::copy_from)
+	@param other value copied
+*/
+void DecimalInteger::copy_from(const DecimalInteger& other) {
+	*this = other;
+}
+
+/** Adds +b (b_sign == 0) or -b (b_sign == 1) to lhs, in place
+	@param b magnitude being added, which must not point into lhs
+	@param bn number of limbs of b
+	@param b_sign sign of b
+*/
+void DecimalInteger::add_magnitude(const limb* b, std::size_t bn, bool b_sign) {
+	if (bn == 0) {
+		return;
+	}
+	std::size_t an = mag.size();
+	if (an < bn) {
+		mag.resize(bn, 0);
+	}
+	bool subtract = (an != 0 && sign != b_sign);
+	limb carry = add_signed<DecimalLimbs>(mag.data(), an, sign, b, bn, b_sign);
+	if (carry) {
+		mag.push_back(carry);
+	}
+	else if (subtract) { // the difference may be shorter
+		clean_up();
+	}
+}
+
+/** Adds value to lhs
+	@param value the value being added
+*/
+DecimalInteger& DecimalInteger::operator+=(const DecimalInteger& value) {
+	if (&value == this) { // a + a = 2a
+		return mul_limb(2);
+	}
+	add_magnitude(value.mag.data(), value.mag.size(), value.sign);
+	return (*this);
+}
+
+/** Subtracts value from lhs
+	@param value the value being subtracted
+*/
+DecimalInteger& DecimalInteger::operator-=(const DecimalInteger& value) {
+	if (&value == this) { // a - a = 0
+		mag.clear();
+		sign = 0;
+		return (*this);
+	}
+	add_magnitude(value.mag.data(), value.mag.size(), !value.sign);
+	return (*this);
+}
+
+/** Multiplies lhs by a single limb
+	@param y unsigned multiplier
+*/
+DecimalInteger& DecimalInteger::mul_limb(limb y) {
+	if (y == 0) {
+		mag.clear();
+		sign = 0;
+		return (*this);
+	}
+	limb carry = 0;
+	for (std::size_t i = 0, n = mag.size(); i < n; ++i) {
+		carry = divide_base((dlimb)mag[i] * y + carry, mag[i]);
+	}
+	while (carry) { // the carry may exceed one limb
+		limb digit;
+		carry = divide_base(carry, digit);
+		mag.push_back(digit);
+	}
+	return (*this);
+}
+
+/** Adds x*y to acc for a single limb y
+	@param acc accumulator (updated in place)
+	@param x
+	@param y unsigned multiplier
+*/
+void addmul_limb(DecimalInteger& acc, const DecimalInteger& x, limb y) {
+	DecimalInteger::add_product_limb(acc, x, y, false);
+}
+
+/** Subtracts x*y from acc for a single limb y
+	@param acc accumulator (updated in place)
+	@param x
+	@param y unsigned multiplier
+*/
+void submul_limb(DecimalInteger& acc, const DecimalInteger& x, limb y) {
+	DecimalInteger::add_product_limb(acc, x, y, true);
+}
+
+/** Adds x*y or -x*y to acc for a single limb y; acc may be x
+	@param acc accumulator (updated in place)
+	@param x
+	@param y unsigned multiplier
+	@param negate subtracts x*y instead
+*/
+void DecimalInteger::add_product_limb(DecimalInteger& acc, const DecimalInteger& x, limb y, bool negate) {
+	std::size_t xn = x.mag.size();
+	if (xn == 0 || y == 0) {
+		return;
+	}
+	bool product_sign = x.sign != negate; // the sign of the term added to acc
+	if (&acc != &x && (acc.mag.empty() || acc.sign == product_sign)) { // Same sign: accumulate straight into acc
+		if (acc.mag.size() < xn) {
+			acc.mag.resize(xn, 0);
+		}
+		acc.mag.push_back(0); // room for the carries (removed again by clean_up)
+		acc.mag.push_back(0);
+		limb carry = addmul_1(&acc.mag[0], x.mag.data(), xn, y);
+		for (std::size_t j = xn; carry; ++j) { // propagate the carry
+			dlimb t = (dlimb)acc.mag[j] + carry;
+			carry = divide_base(t, acc.mag[j]);
+		}
+		acc.sign = product_sign;
+		acc.clean_up();
+		return;
+	}
+
+	// Opposite signs (or aliasing): form the product in the scratch buffer, then add it
+	std::vector<limb>& c = product_scratch<std::vector<limb> >();
+	c.assign(x.mag.begin(), x.mag.end());
+	limb carry = 0;
+	for (std::size_t i = 0; i < xn; ++i) {
+		carry = divide_base((dlimb)c[i] * y + carry, c[i]);
+	}
+	while (carry) {
+		limb digit;
+		carry = divide_base(carry, digit);
+		c.push_back(digit);
+	}
+	acc.add_magnitude(c.data(), c.size(), product_sign);
+}
+
+/** Flips the sign
+	@return the implicit parameter with opposite sign
+*/
+DecimalInteger DecimalInteger::operator-() const {
+	DecimalInteger a(*this);
+	a.sign = !(sign);
+	a.clean_up(); // -0 is 0
+	return a;
+}
+
+/** Prints the lhs in base 10: "####" if positive, and "-####" if negative
+	@param out specifies the type of output: cout or outputData
+*/
+void DecimalInteger::print_as_int(std::ostream& out) const {
+	if (mag.empty()) {
+		out << '0';
+		return;
+	}
+
+	std::string digits;
+	digits.reserve(mag.size() * 19 + 1);
+	if (sign == 1) { // If the number is negative, output is of the form -####
+		digits += '-';
+	}
+	digits += std::to_string(mag.back()); // leading limb is printed without padding
+	char group[19];
+	for (std::size_t i = mag.size() - 1; i-- > 0; ) { // every other limb is exactly 19 digits
+		limb value = mag[i];
+		for (int d = 18; d >= 0; --d) {
+			group[d] = (char)('0' + value % 10);
+			value /= 10;
+		}
+		digits.append(group, 19);
+	}
+
+	out << digits;
+}
+
+/** Converts the lhs to an Integer (Horner's rule in base 10^19)
+	@return the same value as an Integer
+*/
+Integer DecimalInteger::to_integer() const {
+	const Integer one = 1;
+	const Integer radix = Integer::from_limb(base);
+	Integer result;
+	for (std::size_t i = mag.size(); i-- > 0; ) {
+		result *= radix;
+		addmul_limb(result, one, mag[i]);
+	}
+	return sign ? -std::move(result) : result;
+}
+
+/** Returns the number of limbs in the magnitude of lhs
+	@return number of limbs (0 for zero)
+*/
+std::size_t DecimalInteger::size() const {
+	return mag.size();
+}
+
+/** Returns true if lhs < rhs (otherwise returns false)
+	@param rhs
+	@return true if lhs < rhs
+*/
+bool DecimalInteger::operator<(const DecimalInteger& rhs) const {
+	if (sign != rhs.sign) { // Then exactly one of them is negative
+		return sign == 1;
+	}
+	int cmp = compare_magnitude(mag.data(), mag.size(), rhs.mag.data(), rhs.mag.size());
+	return sign == 0 ? cmp < 0 : cmp > 0; // For negative numbers, a larger magnitude indicates less than
+}
+
+/** Returns true if lhs == rhs (otherwise returns false)
+	@param rhs
+	@return true if lhs == rhs
+*/
+bool DecimalInteger::operator==(const DecimalInteger& rhs) const {
+	return sign == rhs.sign && mag == rhs.mag;
+}
+
+/** Removes leading zeros (and gives zero a positive sign)
+*/
+void DecimalInteger::clean_up() {
+	while (!mag.empty() && mag.back() == 0) {
+		mag.pop_back();
+	}
+	if (mag.empty()) {
+		sign = 0;
+	}
+}
+
+/** Adds a and b; returns the result
+	@param a
+	@param b
+	@return a + b
+*/
+DecimalInteger operator+(DecimalInteger a, const DecimalInteger& b) {
+	a += b;
+	return a;
+}
+
+/** Subtracts a and b; returns the result
+	@param a
+	@param b
+	@return a - b
+*/
+DecimalInteger operator-(DecimalInteger a, const DecimalInteger& b) {
+	a -= b;
+	return a;
+}
+
+/** Returns true if lhs != rhs (otherwise, false)
+*/
+bool operator!=(const DecimalInteger& lhs, const DecimalInteger& rhs) {
+	return !(lhs == rhs);
+}
+
+/** Returns true if lhs > rhs (otherwise, false)
+*/
+bool operator>(const DecimalInteger& lhs, const DecimalInteger& rhs) {
+	return rhs < lhs;
+}
+
+/** Returns true if lhs <= rhs (otherwise, false)
+*/
+bool operator<=(const DecimalInteger& lhs, const DecimalInteger& rhs) {
+	return !(lhs > rhs);
+}
+
+/** Returns true if lhs >= rhs (otherwise, false)
+*/
+bool operator>=(const DecimalInteger& lhs, const DecimalInteger& rhs) {
+	return !(lhs < rhs);
+}
@@ -0,0 +1,88 @@
+/** @file DecimalInteger.h
+	@brief Contains the class declarations for an integer stored in base 10^19, for output-dominated work
+
+	A DecimalInteger supports the operations that the table recurrences need:
+	1. added or subtracted:					a + b; a - b; a += b; a -= b;
+	2. multiplied by a small (limb) factor:	a.mul_limb(y); addmul_limb(acc, x, y); submul_limb(acc, x, y);
+	3. change of sign:						-a;
+	4. compared:							a < b; a <= b; a == b; a != b; a >= b; a > b;
+	5. displayed in base 10:				a.print_as_int(); out << a;
+	6. converted from and to Integer:		DecimalInteger(i); a.to_integer();
+
+	Each limb holds 19 decimal digits, so printing copies digits out limb by limb and never divides.
+*/
+
+#ifndef DECIMAL_INTEGER_H
+#define DECIMAL_INTEGER_H
+
+#include "Integer.h"
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+/** @class DecimalInteger
+	@brief Stores an integer value using base 10^19 limbs and a reserved signed bit.
+
+Stores integer values as vectors of limbs below 10^19 (least significant limb first), using the sign and magnitude
+format. Zero is stored as an empty magnitude with a positive sign.
+
+*/
+class DecimalInteger {
+public:
+	typedef unsigned long long limb; // One base 10^19 digit (19 decimal digits)
+	static const limb base = 10000000000000000000ULL; // 10^19
+
+	friend std::ostream& operator<<(std::ostream& out, const DecimalInteger& d);
+	friend void write_binary(std::ostream& out, const DecimalInteger& value); // Writes value in binary (e.g. for checkpoints)
+	friend bool read_binary(std::istream& in, DecimalInteger& value);		 // Reads a value written by write_binary
+
+	friend void addmul_limb(DecimalInteger& acc, const DecimalInteger& x, limb y); // acc += x*y for a single limb y
+	friend void submul_limb(DecimalInteger& acc, const DecimalInteger& x, limb y); // acc -= x*y for a single limb y
+
+	// Constructors
+	DecimalInteger();		  // Defaults to zero
+	DecimalInteger(int a);  // Converts int to base 10^19
+	explicit DecimalInteger(const Integer& a); // Converts an Integer to base 10^19
+	void copy_from(const DecimalInteger& other); // Copies other into the storage of lhs (as Integer::copy_from)
+
+	// Mutators
+	DecimalInteger& operator+=(const DecimalInteger& value); // Adds value to lhs and returns lhs
+	DecimalInteger& operator-=(const DecimalInteger& value); // Subtracts value from lhs and returns lhs
+	DecimalInteger& mul_limb(limb y);						   // Multiplies lhs by y and returns lhs
+
+	DecimalInteger operator-() const; // -a: flips the sign of a
+
+	// Accessors
+	void print_as_int(std::ostream& out) const; // Prints the lhs in base 10
+	Integer to_integer() const;					// Converts the lhs to an Integer
+	std::size_t size() const;					// Number of limbs in the magnitude of lhs (zero has none)
+
+	// Comparisons
+	bool operator<(const DecimalInteger& rhs) const;  // True if lhs < rhs
+	bool operator==(const DecimalInteger& rhs) const; // True if lhs == rhs
+
+private:
+	void clean_up(); // Removes leading zeros
+	void add_magnitude(const limb* b, std::size_t bn, bool b_sign); // lhs += (+/-)b, b must not alias lhs
+	static void add_product_limb(DecimalInteger& acc, const DecimalInteger& x, limb y, bool negate); // acc += (+/-)x*y (acc may be x)
+
+	std::vector<limb> mag; // magnitude, least significant limb first, without leading zero limbs
+	bool sign; // zero is positive; 1 indicates negative
+};
+
+std::ostream& operator<<(std::ostream& out, const DecimalInteger& d); // Prints d in base 10
+void write_binary(std::ostream& out, const DecimalInteger& value); // Writes value in binary: one word (limbs*2 + sign), then the limbs
+bool read_binary(std::istream& in, DecimalInteger& value);		 // Reads a value written by write_binary (false if the input is cut short)
+
+void addmul_limb(DecimalInteger& acc, const DecimalInteger& x, DecimalInteger::limb y); // acc += x*y for a single limb y
+void submul_limb(DecimalInteger& acc, const DecimalInteger& x, DecimalInteger::limb y); // acc -= x*y for a single limb y
+
+DecimalInteger operator+(DecimalInteger a, const DecimalInteger& b); // Adds a + b
+DecimalInteger operator-(DecimalInteger a, const DecimalInteger& b); // Subtracts a - b
+
+bool operator!=(const DecimalInteger& lhs, const DecimalInteger& rhs); // True if lhs != rhs
+bool operator>(const DecimalInteger& lhs, const DecimalInteger& rhs);  // True if lhs > rhs
+bool operator<=(const DecimalInteger& lhs, const DecimalInteger& rhs); // True if lhs <= rhs
+bool operator>=(const DecimalInteger& lhs, const DecimalInteger& rhs); // True if lhs >= rhs
+
+#endif //Ends the include guard
@@ -5,6 +5,9 @@
 Positive and negative integer types are stored as objects of a class Integer so that they can be:
 1. added, subtracted, or multiplied:	a + b; a - b; a * b;
 1a.										a += b; a -= b; a *= b;
+										a.mul_limb(y);
+1b. fused multiply-add:					addmul(acc, x, y); submul(acc, x, y);
+										addmul_limb(acc, x, y); submul_limb(acc, x, y);
 2. incremented:							++a; a++; --a; a--;
 3. shifted:								a << increment; a >> increment;
 3a.										a <<= increment; a >>= increment;
@@ -15,9 +18,14 @@ Positive and negative integer types are stored as objects of a class Integer so
 7. displayed in base 10 or base 2:		a.print_as_int(); a.print_as_bits();
 
 Additional useful functions defined outside of the Integer class:
-Integer operator+(Integer a, const Integer& b); // Adds a + b
-Integer operator-(Integer a, const Integer& b); // Subtracts a - b
-Integer operator*(Integer a, const Integer& b); // Multiplies a * b
+Integer operator+(const Integer& a, const Integer& b); // Adds a + b (plus overloads reusing rvalue operands)
+Integer operator-(const Integer& a, const Integer& b); // Subtracts a - b (plus overloads reusing rvalue operands)
+Integer operator*(const Integer& a, const Integer& b); // Multiplies a * b (plus overloads reusing rvalue operands)
+
+void addmul(Integer& acc, const Integer& x, const Integer& y); // acc += x*y without temporaries
+void submul(Integer& acc, const Integer& x, const Integer& y); // acc -= x*y without temporaries
+void addmul_limb(Integer& acc, const Integer& x, Integer::limb y); // acc += x*y for a single limb y
+void submul_limb(Integer& acc, const Integer& x, Integer::limb y); // acc -= x*y for a single limb y
 
 bool operator!=(const Integer& lhs, const Integer& rhs); // True if lhs != rhs
 bool operator>(const Integer& lhs, const Integer& rhs);  // True if lhs > rhs
@@ -28,17 +36,212 @@ Integer operator&(Integer a, const Integer& b); // And: returns result of a&b (b
 Integer operator|(Integer a, const Integer& b); // Or:  returns result of a|b (bitwise)
 Integer operator^(Integer a, const Integer& b); // Xor: returns result of a^b (bitwise)
 
-Integer operator<<(Integer& a, const unsigned int& increment); // Returns a shifted up increment number of times
-Integer operator>>(Integer& a, const unsigned int& increment); // Returns a shifted down increment number of times
+Integer operator<<(Integer a, const unsigned int& increment); // Returns a shifted up increment number of times
+Integer operator>>(Integer a, const unsigned int& increment); // Returns a shifted down increment number of times
+
+std::size_t karatsuba_threshold();				 // Operand size (limbs) from which products use Karatsuba's method
+void set_karatsuba_threshold(std::size_t limbs); // Sets it
+std::size_t ntt_threshold();					 // Operand size (limbs) from which products use number theoretic transforms
+void set_ntt_threshold(std::size_t limbs);		 // Sets it
+
+Temporaries: the arithmetic works on the limbs of the lhs in place. Products are formed in a per-thread
+scratch buffer which is swapped with the lhs afterwards, so the buffer of the old value is recycled by
+the next product and a long-running computation stops allocating once its buffers have grown.
 
 */
 
 #include <iostream>
 #include <fstream>
 #include "Integer.h"
+#include "IntegerInternal.h"
+#include "IntegerKernels.h"
+#include "IntegerNTT.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <cmath>
+#include <cstdlib>
 #include <vector>
 #include <string>
+#include <utility>
+
+typedef Integer::limb limb;
+typedef unsigned __int128 dlimb; // Holds the product of two limbs
+
+namespace {
+
+/** r = a / d over n limbs (r may alias a)
+	@return the remainder a % d
+*/
+limb divmod_1(limb* r, const limb* a, std::size_t n, limb d) {
+	dlimb rem = 0;
+	for (std::size_t i = n; i-- > 0; ) {
+		dlimb cur = (rem << 64) | a[i];
+		r[i] = (limb)(cur / d);
+		rem = cur % d;
+	}
+	return (limb)rem;
+}
+
+/** Returns a threshold from the environment if it is set (and at least 2), otherwise its default
+	@param variable name of the environment variable (INTEGER_KARATSUBA or INTEGER_NTT)
+	@param fallback default number of limbs
+*/
+std::size_t threshold_from_environment(const char* variable, std::size_t fallback) {
+	const char* forced = std::getenv(variable);
+	if (forced != nullptr && std::strtoul(forced, nullptr, 10) >= 2) {
+		return std::strtoul(forced, nullptr, 10);
+	}
+	return fallback;
+}
+
+/** Operand size (in limbs) from which products use Karatsuba's method (see karatsuba_threshold)
+*/
+std::atomic<std::size_t>& karatsuba_limbs() {
+	static std::atomic<std::size_t> limbs(threshold_from_environment("INTEGER_KARATSUBA", 24));
+	return limbs;
+}
+
+/** Operand size (in limbs) from which products use number theoretic transforms (see ntt_threshold)
+*/
+std::atomic<std::size_t>& ntt_limbs() {
+	static std::atomic<std::size_t> limbs(threshold_from_environment("INTEGER_NTT", 5000));
+	return limbs;
+}
+
+/** r = a * b over an + bn limbs (schoolbook), where r does not overlap a or b
+*/
+void schoolbook_limbs(limb* r, const limb* a, std::size_t an, const limb* b, std::size_t bn) {
+	const LimbKernels& kernels = limb_kernels();
+	std::fill(r, r + an, (limb)0);
+	for (std::size_t i = 0; i < bn; ++i) {
+		r[i + an] = kernels.addmul_1(&r[i], a, an, b[i]);
+	}
+}
+
+/** d = |x - y| over xn limbs, where xn >= yn (y is padded with zeros)
+	@return true if x < y
+*/
+bool subtract_abs(limb* d, const limb* x, std::size_t xn, const limb* y, std::size_t yn) {
+	const LimbKernels& kernels = limb_kernels();
+	bool less = false;
+	std::size_t top = xn;
+	while (top > yn && x[top - 1] == 0) { // the limbs of x above y decide, unless they are zero
+		d[--top] = 0;
+	}
+	if (top == yn) {
+		less = compare_magnitude(x, yn, y, yn) < 0;
+	}
+	if (less) {
+		kernels.sub_n(d, y, x, yn);
+		return true;
+	}
+	limb borrow = kernels.sub_n(d, x, y, yn);
+	for (std::size_t i = yn; i < top; ++i) {
+		d[i] = x[i] - borrow;
+		borrow = (x[i] < borrow);
+	}
+	return false;
+}
+
+/** r = a * b over an + bn limbs by Karatsuba's method, where r does not overlap a or b
+	@param w workspace of at least 6 (an + bn) + 1024 limbs
+*/
+void multiply_limbs(limb* r, const limb* a, std::size_t an, const limb* b, std::size_t bn, limb* w) {
+	const LimbKernels& kernels = limb_kernels();
+	if (an < bn) {
+		std::swap(a, b);
+		std::swap(an, bn);
+	}
+	if (bn < karatsuba_limbs().load(std::memory_order_relaxed)) {
+		schoolbook_limbs(r, a, an, b, bn);
+		return;
+	}
+	if (bn >= ntt_limbs().load(std::memory_order_relaxed)) {
+		ntt_multiply(r, a, an, b, bn);
+		return;
+	}
+
+	std::size_t h = (an + 1) / 2; // a = a0 + a1 B^h, b = b0 + b1 B^h with B = 2^64
+	if (bn <= h) { // Unbalanced: multiply b by pieces of a of bn limbs each, and add up the pieces
+		std::fill(r, r + an + bn, (limb)0);
+		for (std::size_t i = 0; i < an; i += bn) {
+			std::size_t cn = std::min(bn, an - i);
+			multiply_limbs(w, a + i, cn, b, bn, w + cn + bn);
+			limb carry = kernels.add_n(r + i, r + i, w, cn + bn);
+			for (std::size_t j = i + cn + bn; carry; ++j) {
+				carry = (++r[j] == 0);
+			}
+		}
+		return;
+	}
+
+	// a b = z0 + (z0 + z2 - (a0 - a1)(b0 - b1)) B^h + z2 B^2h, with z0 = a0 b0 and z2 = a1 b1
+	std::size_t a1n = an - h, b1n = bn - h, zn = an + bn - 2 * h;
+	bool square = (a == b && an == bn);
+	limb* da = w;				// |a0 - a1|, h limbs
+	limb* db = w + h;			// |b0 - b1|, h limbs
+	limb* m = w + 2 * h + 1;	// |a0 - a1| |b0 - b1|, 2h limbs
+	limb* t = w;				// z0 + z2 -/+ m, 2h + 1 limbs (replaces da and db once m is formed)
+	limb* next = w + 4 * h + 2; // workspace of the recursive calls
+	multiply_limbs(r, a, h, b, h, next);				 // z0
+	multiply_limbs(r + 2 * h, a + h, a1n, b + h, b1n, next); // z2
+	bool negative = subtract_abs(da, a, h, a + h, a1n);
+	if (square) { // (a0 - a1)^2 is never negative
+		negative = false;
+		multiply_limbs(m, da, h, da, h, next);
+	}
+	else {
+		negative = (negative != subtract_abs(db, b, h, b + h, b1n));
+		multiply_limbs(m, da, h, db, h, next);
+	}
+
+	std::copy(r, r + 2 * h, t);
+	limb carry = kernels.add_n(t, t, r + 2 * h, zn);
+	for (std::size_t i = zn; i < 2 * h; ++i) {
+		t[i] += carry;
+		carry = (t[i] < carry);
+	}
+	t[2 * h] = carry;
+	if (negative) { // (a0 - a1)(b0 - b1) < 0
+		t[2 * h] += kernels.add_n(t, t, m, 2 * h);
+	}
+	else {
+		t[2 * h] -= kernels.sub_n(t, t, m, 2 * h);
+	}
+
+	std::size_t tn = std::min(2 * h + 1, an + bn - h); // the middle term fits in the rest of r
+	carry = kernels.add_n(r + h, r + h, t, tn);
+	for (std::size_t i = h + tn; carry; ++i) {
+		carry = (++r[i] == 0);
+	}
+}
+
+/** r = a * b; r is resized to an + bn limbs (then trimmed) and must not alias a or b
+	Products of operands of at least karatsuba_threshold() limbs use Karatsuba's method, and those of at least
+	ntt_threshold() limbs number theoretic transforms.
+*/
+void mul_into(Integer::storage& r, const limb* a, std::size_t an, const limb* b, std::size_t bn) {
+	r.clear(); // the old limbs are not needed (and, if they are shared, not copied)
+	r.resize(an + bn);
+	std::size_t smaller = std::min(an, bn);
+	if (smaller < karatsuba_limbs().load(std::memory_order_relaxed)) {
+		schoolbook_limbs(r.data(), a, an, b, bn);
+	}
+	else if (smaller >= ntt_limbs().load(std::memory_order_relaxed)) {
+		ntt_multiply(r.data(), a, an, b, bn);
+	}
+	else {
+		thread_local std::vector<limb> workspace;
+		workspace.resize(6 * (an + bn) + 1024);
+		multiply_limbs(r.data(), a, an, b, bn, workspace.data());
+	}
+	while (!r.empty() && r.back() == 0) {
+		r.pop_back();
+	}
+}
+
+}
 
 /** Output operator <<
 	@param out allows std::cout, etc output types
@@ -50,168 +253,195 @@ std::ostream& operator<<(std::ostream& out, const Integer& i) {
 	return out;
 }
 
-/** Input operator >>
+/** Input operator >>: reads an optional sign followed by any number of decimal digits
 	@param in allows std::cin, etc input types
 	@param i accepts an Integer type input
-	@return in so that >> can be called consecutively
+	@return in so that >> can be called consecutively (failbit is set if there are no digits)
 */
 std::istream& operator>>(std::istream& in, Integer& i) {
-	int input;
-	in >> input;
-	i = input;
+	std::istream::sentry skip_whitespace(in);
+	if (!skip_whitespace) {
+		return in;
+	}
+	bool negative = false;
+	if (in.peek() == '-' || in.peek() == '+') {
+		negative = (in.get() == '-');
+	}
+	std::string digits;
+	while (std::isdigit(in.peek())) {
+		digits += (char)in.get();
+	}
+	if (digits.empty()) {
+		in.setstate(std::ios::failbit);
+		return in;
+	}
+
+	INTEGER_STATS_SCOPE(parse, digits.size() / 19 + 1); // the conversion (reading the characters is not timed)
+
+	// Horner's rule in base 10^19: the leading group is the first (length mod 19) digits
+	const LimbKernels& kernels = limb_kernels();
+	const limb ten_19 = 10000000000000000000ULL;
+	Integer::storage mag;
+	mag.reserve(digits.size() / 19 + 1);
+	for (std::size_t start = 0, length = (digits.size() - 1) % 19 + 1; start < digits.size(); start += length, length = 19) {
+		limb group = 0;
+		for (std::size_t d = start; d < start + length; ++d) {
+			group = group * 10 + (limb)(digits[d] - '0');
+		}
+		limb carry = mag.empty() ? 0 : kernels.mul_1(&mag[0], &mag[0], mag.size(), ten_19);
+		for (std::size_t j = 0; group != 0 && j < mag.size(); ++j) { // add the group
+			mag[j] += group;
+			group = (mag[j] < group);
+		}
+		carry += group;
+		if (carry != 0) {
+			mag.push_back(carry);
+		}
+	}
+	i.mag.swap(mag);
+	i.sign = negative;
+	i.clean_up();
 	return in;
 }
 
 
+/** Writes value in binary: one word holding (number of limbs)*2 + sign, then the limbs (in the byte order of the machine)
+	@param out destination (opened in binary mode)
+	@param value the value to write
+*/
+void write_binary(std::ostream& out, const Integer& value) {
+	limb header = (limb)value.mag.size() * 2 + value.sign;
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(value.mag.data()), (std::streamsize)(value.mag.size() * sizeof(limb)));
+}
+
+/** Reads a value written by write_binary
+	@param in source (opened in binary mode)
+	@param value receives the value
+	@return false if the input ended too early or is not a valid value
+*/
+bool read_binary(std::istream& in, Integer& value) {
+	limb header;
+	if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+		return false;
+	}
+	value.mag.resize((std::size_t)(header / 2));
+	value.sign = (header & 1) != 0;
+	if (!in.read(reinterpret_cast<char*>(value.mag.data()), (std::streamsize)(value.mag.size() * sizeof(limb)))) {
+		return false;
+	}
+	return (value.mag.empty() && !value.sign) || (!value.mag.empty() && value.mag.back() != 0);
+}
+
 /** Default constructor of Integer class
 */
-Integer::Integer() {
-	bit = { 0 };
-	sign = 0;
+Integer::Integer() : sign(0) {
 }
 
 /** Constructor of Integer class with parameter
     @param a is an integer in base 10, which is stored in base 2
 */
 Integer::Integer(int a) {
-	bit = {};    // Intialize bit
-	if (a < 0) { // If a is negative, sign is negative
+	long long value = a; // widened so that -INT_MIN is representable
+	if (value < 0) { // If a is negative, sign is negative
 		sign = 1;
-		a = -a;  // We change the sign of a for the next step: binary conversion
+		value = -value;
 	}
 	else {		 // Otherwise, a is positive and the sign is positive
 		sign = 0;
 	}
-
-	// Integer to binary conversion
-	while (a > 1) { // If a > 1, its binary representation will be more than one digit long (digits are determined in reverse order in this method)
-		if (a % 2 == 0) { // Then a is divisible by 2 and inserts 0 at first position, moving the other entries back
-			bit.insert(bit.begin(), 0);
-		}
-		else { // a is not divisible by 2: inserts the remainder (1) at first position, moving the other entries back
-			bit.insert(bit.begin(), 1);
-		}
-		a = a / 2; // integer division
-	}
-
-	// Using the above method, a = 1 and the first digit is one
-	if (a == 1) {
-		bit.insert(bit.begin(), 1);
+	if (value != 0) { // zero is stored without limbs
+		mag.push_back((limb)value);
 	}
+}
 
-	// The only exception to the above is if the initial value is zero
-	else if (a == 0) {
-		bit.insert(bit.begin(), 0);
+/** Converts a single limb to an Integer (for values that do not fit in an int)
+	@param a unsigned 64-bit value
+	@return a as an Integer
+*/
+Integer Integer::from_limb(limb a) {
+	Integer result;
+	if (a != 0) {
+		result.mag.push_back(a);
 	}
+	return result;
+}
 
-	else { // We've covered all the cases, so this should never be printed (for debugging purposes only)
-		std::cout << "Error in constructor class!";
-	}
+/** Copies a magnitude given as an array of limbs
+	@param limbs the magnitude, least significant limb first
+	@param n number of limbs (leading zero limbs are removed)
+	@param negative true for a negative value
+	@return the Integer
+*/
+Integer Integer::from_limbs(const limb* limbs, std::size_t n, bool negative) {
+	Integer result;
+	result.mag.assign(limbs, limbs + n);
+	result.sign = negative;
+	result.clean_up();
+	return result;
 }
 
-/** Adds value to lhs
-    @param value the value being added, in base 2
+/** Move constructor of Integer class
+	@param other is left as zero
 */
-Integer& Integer::operator+=(const Integer& value) {
-	// Temp values: a + b = c
-	Integer a;         // Copy of lhs
-	a.bit = bit;
-	a.sign = sign;
-	Integer b = value; // Amount being added to lhs (copy)
-	b.sign = value.sign;
-	Integer c = 0;     // Solution to addition of a and b
-
-	// Determine sign of c
-	// If the magnitude of a is less than the magnitude of b, c is the sign of b
-	if (a.sign == b.sign) {
-		c.sign = a.sign;
-	}
-	// Note: Integers are stored without leading zeros, so comparing sizes can determine inequality.
-	else {
-		if (a.bit.size() < b.bit.size()) { // if length lhs < length rhs ==> lhs < rhs
-			c.sign = b.sign;
-		}
-		else if (a.bit.size() > b.bit.size()) { // if length lhs > length rhs ==> lhs > rhs
-			c.sign = a.sign;
-		}
-		else { // length of lhs == length rhs (need to compare bitwise)
-			for (size_t i = a.bit.size() - 1; i <= 0; --i) { // compares each bit, starting with the first
-				if (a.bit[i] < b.bit[i]) { // entry of a < entry of b
-					c.sign = b.sign; // a < b
-					break;
-				}
-				else if (a.bit[i] > b.bit[i]) { // entry of a > entry of b
-					c.sign = a.sign; // a > b
-					break;
-				}
-				else { //lhs == rhs for all entries
-					c.sign = a.sign;
-				}
-			}
-		}
-	}
+Integer::Integer(Integer&& other) noexcept : mag(std::move(other.mag)), sign(other.sign) {
+	other.mag.clear();
+	other.sign = 0;
+}
 
+/** Move assignment: swaps storage with other so that the old limbs of lhs can be reused by other
+	@param other is left holding the old value of lhs
+*/
+Integer& Integer::operator=(Integer&& other) noexcept {
+	mag.swap(other.mag);
+	std::swap(sign, other.sign);
+	return (*this);
+}
 
-	// Size Increase
-	// We need to increase the sizes of a and b so that they are the same size and have two leading zeros (so there's no index issue for carrying)
-	if (a.bit.size() < b.bit.size()) { // Then increase a with leading zeros to 2 + the size of b
-		while (a.bit.size() < b.bit.size() + 2) { // Increases size of a until it is 2 + the size of b
-			a.bit.insert(a.bit.begin(), 0);
-		}
-		b.bit.insert(b.bit.begin(), 0); // Increase b
-		b.bit.insert(b.bit.begin(), 0);
-	}
-	else if (a.bit.size() > b.bit.size()) { // Then increase b with leading zeros to 2 + the size of a
-		while (b.bit.size() < a.bit.size() + 2) { // Increases size of b until it is 2 + the size of a
-			b.bit.insert(b.bit.begin(), 0);
-		}
-		a.bit.insert(a.bit.begin(), 0); // Increase a
-		a.bit.insert(a.bit.begin(), 0);
-	}
-	else { // Then a is the same size as b. Increase both with two leading zeros.
-		a.bit.insert(a.bit.begin(), 0);
-		a.bit.insert(a.bit.begin(), 0);
-		b.bit.insert(b.bit.begin(), 0);
-		b.bit.insert(b.bit.begin(), 0);
+/** Copies the value of other into the storage of lhs. Unlike the copy assignment, this never shares the limbs
+	with INTEGER_COW: a value that is about to be changed in place keeps its own block instead of sharing
+	other's and then allocating a private copy of it
+	@param other value copied
+*/
+void Integer::copy_from(const Integer& other) {
+	if (&other != this) {
+		mag.assign(other.mag.begin(), other.mag.end());
+		sign = other.sign;
 	}
+}
 
-	// Two's Compelement Conversion
-	// If a or b are negative, we convert them to two's compelement to solve
-	if (a.sign == 1) {
-		//convert to two's complement: flip bits (including signed bit), then add one 
-		a = ~a;
-		++a;
+/** Adds +b (b_sign == 0) or -b (b_sign == 1) to lhs, in place
+	@param b magnitude being added, which must not point into lhs
+	@param bn number of limbs of b
+	@param b_sign sign of b
+*/
+void Integer::add_magnitude(const limb* b, std::size_t bn, bool b_sign) {
+	if (bn == 0) {
+		return;
 	}
-	if (b.sign == 1) {
-		//convert to two's complement: flip bits (including signed bit), then add one
-		b = ~b;
-		++b;
+	std::size_t an = mag.size();
+	if (an < bn) {
+		mag.resize(bn, 0);
 	}
-
-	// Addition Operation
-	bool carry = 0; // "carried" digit in addition method
-	unsigned int temp = 0; // temporary value used in addition method
-
-	// Adds each digit, starting with the last entry (and carrying, if necessary)
-	for (size_t i = 0, n = a.bit.size(); i < n; ++i) { //credit: Prof. DeSalvo's Syle lecture
-		temp = a.bit[a.bit.size() - 1 - i] + b.bit[b.bit.size() - 1 - i] + carry;
-		c.bit.insert(c.bit.begin(), temp % 2); //note: last digit of c is zero from initialization. Next step is to remove the erroneous zero.
-		carry = temp / 2;
+	bool subtract = (an != 0 && sign != b_sign);
+	limb carry = add_signed<BinaryLimbs>(mag.data(), an, sign, b, bn, b_sign);
+	if (carry) {
+		mag.push_back(carry);
 	}
-	// Remove trailing zero (erroneous)
-	c.bit.pop_back();
-
-	// If c is negative, convert from two's complement back to sign and magnitude (note that the sign of c has already been determined, so we don't flip the sign)
-	sign = c.sign;
-	if (c.sign == 1) {
-		c = ~c;
-		++c;
+	else if (subtract) { // the difference may be shorter
+		clean_up();
 	}
+}
 
-	// Remove leading zeros (if there are any)
-	c.clean_up();
-
-	bit = c.bit; //reassigns c to lhs
+/** Adds value to lhs
+    @param value the value being added, in base 2
+*/
+Integer& Integer::operator+=(const Integer& value) {
+	INTEGER_STATS_SCOPE(add, std::max(mag.size(), value.mag.size()));
+	if (&value == this) { // a + a = 2a
+		return (*this) <<= 1;
+	}
+	add_magnitude(value.mag.data(), value.mag.size(), value.sign);
 	return (*this);
 }
 
@@ -219,12 +449,14 @@ Integer& Integer::operator+=(const Integer& value) {
     @param value the value being subtracted, in base 2
 */
 Integer& Integer::operator-=(const Integer& value) {
-	// We create a new variable with opposite sign of value
-	Integer b = -value;
-
-	// Now lhs - value becomes lhs + (-value) and we use the += operator
-	(*this) += b;
-	(*this).clean_up();
+	INTEGER_STATS_SCOPE(sub, std::max(mag.size(), value.mag.size()));
+	if (&value == this) { // a - a = 0
+		mag.clear();
+		sign = 0;
+		return (*this);
+	}
+	// lhs - value becomes lhs + (-value)
+	add_magnitude(value.mag.data(), value.mag.size(), !value.sign);
 	return (*this);
 }
 
@@ -232,45 +464,218 @@ Integer& Integer::operator-=(const Integer& value) {
     @param value the value being multiplied, in base 2
 */
 Integer& Integer::operator*=(const Integer& value) {
-	// Temp values:  a * b = c							Example: 39*48
-	// Equivalently: a * (temp[1] + 10*temp[2] + ... )  Example: 39*(8 + 40)
-	Integer a;        // Copy of lhs
-	a.bit = bit;
-	a.sign = sign;
-	Integer temp = value; // Amount being mulitiplied to lhs (copy of rhs)
-	temp.sign = 0;		  // Temp value is always positive; sign of solution is determined independently
-	Integer c = 0;        // Solution to multiplication of a and b
-
-	// Multiplication Operation
-	// Computed along a, starting with the last digit
-	for (size_t i = 0, n = a.bit.size(); i < n; ++i) { //credit: Prof. DeSalvo's Syle lecture
-		// If the digit is one, add b + trailing zero correction
-		if (a.bit[a.bit.size() - 1 - i] == 1) {
-			c += temp;
+	INTEGER_STATS_SCOPE(mul, std::max(mag.size(), value.mag.size()));
+	if (mag.empty() || value.mag.empty()) {
+		mag.clear();
+		sign = 0;
+		return (*this);
+	}
+
+	// The product is formed in the scratch buffer, which then trades places with the old magnitude
+	Integer::storage& c = product_scratch<Integer::storage>();
+	mul_into(c, mag.data(), mag.size(), value.mag.data(), value.mag.size());
+	mag.swap(c);
+	sign = (sign != value.sign); // The signs are different, so the solution is negative
+	return (*this);
+}
+
+/** Adds x*y to acc without creating temporaries
+	@param acc accumulator (updated in place)
+	@param x
+	@param y
+*/
+void addmul(Integer& acc, const Integer& x, const Integer& y) {
+	INTEGER_STATS_SCOPE(addmul, std::max(x.mag.size(), y.mag.size()));
+	Integer::add_product(acc, x, y, false);
+}
+
+/** Subtracts x*y from acc without creating temporaries
+	@param acc accumulator (updated in place)
+	@param x
+	@param y
+*/
+void submul(Integer& acc, const Integer& x, const Integer& y) {
+	INTEGER_STATS_SCOPE(submul, std::max(x.mag.size(), y.mag.size()));
+	Integer::add_product(acc, x, y, true);
+}
+
+/** Adds x*y or -x*y to acc; acc may be x or y (or both)
+	@param acc accumulator (updated in place)
+	@param x
+	@param y
+	@param negate subtracts x*y instead
+*/
+void Integer::add_product(Integer& acc, const Integer& x, const Integer& y, bool negate) {
+	std::size_t xn = x.mag.size(), yn = y.mag.size();
+	if (xn == 0 || yn == 0) {
+		return;
+	}
+	bool product_sign = (x.sign != y.sign) != negate; // the sign of the term added to acc
+	if (&acc != &x && &acc != &y && (acc.mag.empty() || acc.sign == product_sign)
+		&& std::min(xn, yn) < karatsuba_limbs().load(std::memory_order_relaxed)) {
+		// Same sign (and a schoolbook product): accumulate the rows of the product straight into acc
+		std::size_t n = xn + yn;
+		if (acc.mag.size() < n) {
+			acc.mag.resize(n, 0);
+		}
+		acc.mag.push_back(0); // room for the final carry (removed again by clean_up)
+		const LimbKernels& kernels = limb_kernels();
+		limb* a = acc.mag.data();
+		for (std::size_t i = 0; i < yn; ++i) {
+			limb carry = kernels.addmul_1(a + i, x.mag.data(), xn, y.mag[i]);
+			for (std::size_t j = i + xn; carry; ++j) { // propagate the carry
+				limb s = a[j] + carry;
+				carry = (s < carry);
+				a[j] = s;
+			}
+		}
+		acc.sign = product_sign;
+		acc.clean_up();
+		return;
+	}
+
+	// Opposite signs, aliasing or a Karatsuba product: form the product in the scratch buffer, then add it
+	Integer::storage& c = product_scratch<Integer::storage>();
+	mul_into(c, x.mag.data(), xn, y.mag.data(), yn);
+	acc.add_magnitude(c.data(), c.size(), product_sign);
+}
+
+/** Adds x*y to acc for a single limb y (e.g. a small row or column index)
+	@param acc accumulator (updated in place)
+	@param x
+	@param y unsigned multiplier
+*/
+void addmul_limb(Integer& acc, const Integer& x, limb y) {
+	INTEGER_STATS_SCOPE(addmul_limb, std::max(acc.mag.size(), x.mag.size()));
+	Integer::add_product_limb(acc, x, y, false);
+}
+
+/** Subtracts x*y from acc for a single limb y
+	@param acc accumulator (updated in place)
+	@param x
+	@param y unsigned multiplier
+*/
+void submul_limb(Integer& acc, const Integer& x, limb y) {
+	INTEGER_STATS_SCOPE(submul_limb, std::max(acc.mag.size(), x.mag.size()));
+	Integer::add_product_limb(acc, x, y, true);
+}
+
+/** Adds x*y or -x*y to acc for a single limb y; acc may be x
+	@param acc accumulator (updated in place)
+	@param x
+	@param y unsigned multiplier
+	@param negate subtracts x*y instead
+*/
+void Integer::add_product_limb(Integer& acc, const Integer& x, limb y, bool negate) {
+	std::size_t xn = x.mag.size();
+	if (xn == 0 || y == 0) {
+		return;
+	}
+	bool product_sign = x.sign != negate; // the sign of the term added to acc
+	if (&acc != &x && (acc.mag.empty() || acc.sign == product_sign)) { // Same sign: accumulate straight into acc
+		if (acc.mag.size() < xn) {
+			acc.mag.resize(xn, 0);
+		}
+		acc.mag.push_back(0); // room for the final carry (removed again by clean_up)
+		limb* a = acc.mag.data();
+		limb carry = limb_kernels().addmul_1(a, x.mag.data(), xn, y);
+		for (std::size_t j = xn; carry; ++j) { // propagate the carry
+			limb s = a[j] + carry;
+			carry = (s < carry);
+			a[j] = s;
+		}
+		acc.sign = product_sign;
+		acc.clean_up();
+		return;
+	}
+
+	if (&acc != &x) { // Opposite signs: subtract the product from |acc| in place
+		if (acc.mag.size() < xn) {
+			acc.mag.resize(xn, 0);
+		}
+		std::size_t an = acc.mag.size();
+		limb* a = acc.mag.data();
+		limb borrow = limb_kernels().submul_1(a, x.mag.data(), xn, y);
+		for (std::size_t j = xn; borrow && j < an; ++j) { // propagate the borrow
+			limb d = a[j];
+			a[j] = d - borrow;
+			borrow = (d < borrow);
+		}
+		if (borrow) { // |x|*y > |acc|: a holds |acc| - |x|*y + borrow*B^an, so the magnitude is the complement
+			std::size_t j = 0;
+			while (j < an && a[j] == 0) {
+				++j;
+			}
+			if (j < an) { // B^an - a, and one less from borrow
+				a[j] = ~a[j] + 1;
+				for (++j; j < an; ++j) {
+					a[j] = ~a[j];
+				}
+				--borrow;
+			}
+			if (borrow) {
+				acc.mag.push_back(borrow);
+			}
+			acc.sign = product_sign;
 		}
-		// Trailing zero correction: 
-		temp.bit.push_back(0);
+		acc.clean_up();
+		return;
 	}
 
-	// Determine sign
-	if (a.sign == value.sign) { // The signs are the same, so the solution is positive
-		c.sign = 0;
+	// Aliasing: form the product in the scratch buffer, then add it
+	Integer::storage& c = product_scratch<Integer::storage>();
+	c.clear();
+	c.resize(xn + 1);
+	c[xn] = limb_kernels().mul_1(&c[0], x.mag.data(), xn, y);
+	if (c[xn] == 0) {
+		c.pop_back();
 	}
-	else { // The signs are different, so the solution is negative
-		c.sign = 1;
+	acc.add_magnitude(c.data(), c.size(), product_sign);
+}
+
+/** Divides the magnitude of lhs by a single limb, rounding toward zero (the sign of lhs is kept)
+	@param d nonzero divisor
+	@return the remainder |lhs| % d
+*/
+limb Integer::divide_limb(limb d) {
+	INTEGER_STATS_SCOPE(divide_limb, mag.size());
+	if (mag.empty()) {
+		return 0;
 	}
+	limb remainder = divmod_1(&mag[0], &mag[0], mag.size(), d);
+	clean_up();
+	return remainder;
+}
 
-	c.clean_up();
-	bit = c.bit;   //reassigns c to lhs
-	sign = c.sign;
+/** Multiplies lhs by a single limb in place
+	@param y unsigned multiplier; 0 makes lhs zero, keeping its storage for the next value
+*/
+Integer& Integer::mul_limb(limb y) {
+	INTEGER_STATS_SCOPE(mul_limb, mag.size());
+	if (mag.empty() || y == 0) {
+		mag.clear();
+		sign = 0;
+		return (*this);
+	}
+	limb high = limb_kernels().mul_1(&mag[0], &mag[0], mag.size(), y);
+	if (high) {
+		mag.push_back(high);
+	}
 	return (*this);
 }
 
+/** Reserves storage so that lhs can grow to limbs limbs without reallocating
+	@param limbs number of limbs
+*/
+void Integer::reserve(std::size_t limbs) {
+	mag.reserve(limbs);
+}
+
 /** Prefix increment: adds one to lhs
 */
 Integer& Integer::operator++() {
-	Integer one = 1;
-	(*this) += one;	//increments the object
+	const limb one = 1;
+	add_magnitude(&one, 1, 0);	//increments the object
 	return (*this);	//returns the object
 }
 
@@ -285,8 +690,8 @@ Integer Integer::operator++(int unused) {
 /** Prefix decrement: subtracts one from lhs
 */
 Integer& Integer::operator--() {
-	Integer one = 1;
-	*this -= one;	//decrements the object
+	const limb one = 1;
+	add_magnitude(&one, 1, 1);	//decrements the object
 	return *this;	//returns the object
 }
 
@@ -301,33 +706,38 @@ Integer Integer::operator--(int unused){
 /** Flips the sign
     @return the implicit parameter with opposite sign
 */
-Integer Integer::operator-() const {
-	Integer a;
-	a.bit = bit;
+Integer Integer::operator-() const & {
+	Integer a(*this);
 	a.sign = !(sign);
+	a.clean_up(); // -0 is 0
 
 	return a;
 }
 
+/** Flips the sign of an expiring value in place
+    @return the implicit parameter with opposite sign
+*/
+Integer Integer::operator-() && {
+	sign = !(sign);
+	clean_up(); // -0 is 0
+
+	return std::move(*this);
+}
+
 /** Returns a copy of the implicit parameter
     @return the implicit parameter
 */
 Integer Integer::operator+() const {
-	Integer a;
-	a.bit = bit;
-	a.sign = sign;
-
-	return a;
+	return (*this);
 }
 
 /** Returns the magnitude of the implicit parameter
     @return the magnitude of the implicit parameter
 */
 Integer Integer::abs() const {
-	Integer a;
-	a.bit = bit;
+	Integer a(*this);
 	a.sign = 0;
-	
+
 	return a;
 }
 
@@ -335,42 +745,100 @@ Integer Integer::abs() const {
     @param out specifies the type of output: cout or outputData
 */
 void Integer::print_as_int(std::ostream& out) const {
-	std::string negative_indicator = "";
-	if (sign == 1) { // If the number is negative, output is of the form -####
-		negative_indicator = "-";
+	print_as_int(out, mag.data(), mag.size(), sign);
+}
+
+/** Prints a magnitude given as an array of limbs in base 10: "####" if positive, and "-####" if negative
+	@param out specifies the type of output: cout or outputData
+	@param limbs the magnitude, least significant limb first (without leading zero limbs)
+	@param n number of limbs
+	@param negative true for a negative value
+*/
+void Integer::print_as_int(std::ostream& out, const limb* limbs, std::size_t n, bool negative) {
+	INTEGER_STATS_SCOPE(print, n);
+	if (n == 0) {
+		out << '0';
+		return;
 	}
 
-	unsigned int numb = 0;
+	// converts from binary to decimal, 19 digits at a time (least significant group first)
+	const limb ten_19 = 10000000000000000000ULL;
+	Integer::storage quotient(limbs, limbs + n);
+	Integer::storage groups;
+	while (!quotient.empty()) {
+		groups.push_back(divmod_1(&quotient[0], &quotient[0], quotient.size(), ten_19));
+		while (!quotient.empty() && quotient.back() == 0) {
+			quotient.pop_back();
+		}
+	}
 
-	// converts from binary to decimal
-	for (size_t i = 0, n = bit.size(); i < n; ++i) { //credit: Prof. DeSalvo's Syle lecture
-		numb += bit[i] * pow(2, (bit.size() - 1 - i));
+	std::string digits;
+	digits.reserve(groups.size() * 19 + 1);
+	if (negative) { // If the number is negative, output is of the form -####
+		digits += '-';
+	}
+	digits += std::to_string(groups.back()); // leading group is printed without padding
+	char group[19];
+	for (std::size_t g = groups.size() - 1; g-- > 0; ) {
+		limb value = groups[g];
+		for (int d = 18; d >= 0; --d) {
+			group[d] = (char)('0' + value % 10);
+			value /= 10;
+		}
+		digits.append(group, 19);
 	}
 
-	out << negative_indicator << numb;
+	out << digits;
 }
 
 /** Prints the lhs in base 2: "(#####)_2" or "-(#####)_2"
     @param out specifies the type of output: cout or outputData
 */
 void Integer::print_as_bits(std::ostream& out) const {
-	Integer a;
-	a.bit = bit;
-	a.sign = sign;
-
+	INTEGER_STATS_SCOPE(print, mag.size());
 	std::string negative_indicator = " ";
-	if ((sign == 1) && (bit[0] != 0)) { // If the number is negative, output is of the form -(#####)_2 unless it is zero
-		negative_indicator = "-";		// Note this assumes no leading zeros
+	if (sign == 1) { // If the number is negative, output is of the form -(#####)_2 (zero is never negative)
+		negative_indicator = "-";
 	}
 
 	out << negative_indicator << "(";
 
-	//prints the number in binary
-	for (size_t i = 0, n = bit.size(); i < n; ++i) { //credit: Prof. DeSalvo's Syle lecture
-		out << bit[i];
+	//prints the number in binary, without leading zeros
+	std::string bits;
+	for (std::size_t i = mag.size(); i-- > 0; ) {
+		for (int b = 63; b >= 0; --b) {
+			bool bit = (mag[i] >> b) & 1;
+			if (bit || !bits.empty()) {
+				bits += (bit ? '1' : '0');
+			}
+		}
 	}
+	if (bits.empty()) {
+		bits = "0";
+	}
+
+	out << bits << ")_2";
+}
+
+/** Returns the number of limbs in the magnitude of lhs
+	@return number of limbs (0 for zero)
+*/
+std::size_t Integer::size() const {
+	return mag.size();
+}
 
-	out << ")_2";
+/** Returns the magnitude of lhs as an array of size() limbs
+	@return least significant limb first (valid until lhs changes)
+*/
+const limb* Integer::limbs() const {
+	return mag.data();
+}
+
+/** Returns true if lhs is negative
+	@return true if lhs < 0
+*/
+bool Integer::negative() const {
+	return sign;
 }
 
 /** Returns true if lhs < rhs (otherwise returns false)
@@ -378,45 +846,14 @@ void Integer::print_as_bits(std::ostream& out) const {
     @return true if lhs < rhs
 */
 bool Integer::operator<(const Integer& rhs) const {
+	INTEGER_STATS_SCOPE(compare, std::max(mag.size(), rhs.mag.size()));
 	if (sign == rhs.sign) { // The values have the same sign, so we cannot make a quick deduction based on that.
+		int cmp = compare_magnitude(mag.data(), mag.size(), rhs.mag.data(), rhs.mag.size());
 		if (sign == 0) {
-			// Note: Integers are stored without leading zeros, so comparing sizes can determine inequality.
-			if (bit.size() < rhs.bit.size()) { // if length lhs < length rhs ==> lhs < rhs
-				return true;
-			}
-			else if (bit.size() > rhs.bit.size()) { // if length lhs > length rhs ==> lhs > rhs
-				return false;
-			}
-			else { // length of lhs == length rhs (need to compare bitwise)
-				for (size_t i = 0, n = bit.size(); i < n; ++i) { // compares each bit, starting with the first
-					if (bit[i] < rhs.bit[i]) { // entry of lhs < entry of rhs
-						return true; // returns true and stops loop
-					}
-					else if (bit[i] > rhs.bit[i]) { // entry of lhs > entry of rhs
-						return false; // returns false and stops loop
-					}
-				}
-				return false; // if loop completes, lhs == rhs for all entries
-			}
+			return cmp < 0;
 		}
 		else { // For negative numbers, a larger magnitude indicates less than: -20 < -2 < 1 < 20
-			if (bit.size() > rhs.bit.size()) { // if length lhs > length rhs ==> lhs < rhs
-				return true;
-			}
-			else if (bit.size() < rhs.bit.size()) { // if length lhs < length rhs ==> lhs > rhs
-				return false;
-			}
-			else { // length of lhs == length rhs (need to compare bitwise)
-				for (size_t i = 0, n = bit.size(); i < n; ++i) { // compares each bit, starting with the first
-					if (bit[i] > rhs.bit[i]) { // entry of lhs > entry of rhs
-						return true; // returns true and stops loop
-					}
-					else if (bit[i] < rhs.bit[i]) { // entry of lhs < entry of rhs
-						return false; // returns false and stops loop
-					}
-				}
-				return false; // if loop completes, lhs == rhs for all entries
-			}
+			return cmp > 0;
 		}
 	}
 	else if (sign == 1) { // Then lhs is negative and rhs is positive ==> return true
@@ -432,23 +869,9 @@ bool Integer::operator<(const Integer& rhs) const {
     @return true if lhs == rhs
 */
 bool Integer::operator==(const Integer& rhs) const {
-	if (sign == rhs.sign) { // The values have the same sign
-		// Note: Integers are stored without leading zeros, so comparing sizes can determine equality.
-		if (bit.size() != rhs.bit.size()) { // if length lhs != length rhs ==> lhs != rhs
-			return false;
-		}
-		else { // length of lhs == length rhs (need to compare bitwise)
-			for (size_t i = 0, n = bit.size(); i < n; ++i) { // compares each bit, starting with the first
-				if (bit[i] != rhs.bit[i]) { // entry of lhs != entry of rhs
-					return false; // returns false and stops loop
-				}
-			}
-			return true; // if loop completes, lhs == rhs for all entries
-		}
-	}
-	else { // The values have different sign, so they are not equal
-		return false;
-	}
+	INTEGER_STATS_SCOPE(compare, std::max(mag.size(), rhs.mag.size()));
+	// Integers are stored without leading zeros and zero is always positive
+	return sign == rhs.sign && mag == rhs.mag;
 }
 
 /** And equals: changes lhs to the bit-wise comparison of lhs&rhs
@@ -456,19 +879,13 @@ bool Integer::operator==(const Integer& rhs) const {
     @return the bit-wise comparison lhs&rhs
 */
 Integer& Integer::operator&=(const Integer& rhs) {
-	Integer a = rhs; // copy of rhs
-	a.sign = rhs.sign;
-
-	while (a.bit.size() < bit.size()) { // If a is shorter than lhs, increase a to the same length with leading zeros
-		a.bit.insert(a.bit.begin(), 0);
-	}
-
-	while (bit.size() < a.bit.size()) { // If lhs is shorter than a, increase lhs to the same length with leading zeros
-		bit.insert(bit.begin(), 0);
+	INTEGER_STATS_SCOPE(bitwise, std::max(mag.size(), rhs.mag.size()));
+	if (mag.size() > rhs.mag.size()) { // missing limbs of rhs are zero
+		mag.resize(rhs.mag.size());
 	}
 
-	for (size_t i = 0, n = bit.size(); i < n; ++i) { // Compares each entry and changes the lhs accordingly
-		bit[i] = bit[i] & a.bit[i];
+	if (!mag.empty()) { // Compares each entry and changes the lhs accordingly
+		limb_kernels().and_n(&mag[0], &mag[0], rhs.mag.data(), mag.size());
 	}
 
 	(*this).clean_up(); //remove leading zeros
@@ -480,19 +897,13 @@ Integer& Integer::operator&=(const Integer& rhs) {
     @return the bit-wise comparison lhs|rhs
 */
 Integer& Integer::operator|=(const Integer& rhs) {
-	Integer a = rhs; // copy of rhs
-	a.sign = rhs.sign;
-
-	while (a.bit.size() < bit.size()) { // If a is shorter than lhs, increase a to the same length with leading zeros
-		a.bit.insert(a.bit.begin(), 0);
+	INTEGER_STATS_SCOPE(bitwise, std::max(mag.size(), rhs.mag.size()));
+	if (mag.size() < rhs.mag.size()) { // If lhs is shorter than rhs, increase lhs to the same length with leading zeros
+		mag.resize(rhs.mag.size(), 0);
 	}
 
-	while (bit.size() < a.bit.size()) { // If lhs is shorter than a, increase lhs to the same length with leading zeros
-		bit.insert(bit.begin(), 0);
-	}
-
-	for (size_t i = 0, n = bit.size(); i < n; ++i) { // Compares each entry and changes the lhs accordingly
-		bit[i] = bit[i] | a.bit[i];
+	if (!rhs.mag.empty()) { // Compares each entry and changes the lhs accordingly
+		limb_kernels().or_n(&mag[0], &mag[0], rhs.mag.data(), rhs.mag.size());
 	}
 
 	(*this).clean_up(); //remove leading zeros
@@ -504,19 +915,13 @@ Integer& Integer::operator|=(const Integer& rhs) {
     @return the bit-wise comparison lhs^rhs
 */
 Integer& Integer::operator^=(const Integer& rhs) {
-	Integer a = rhs; // copy of rhs
-	a.sign = rhs.sign;
-
-	while (a.bit.size() < bit.size()) { // If a is shorter than lhs, increase a to the same length with leading zeros
-		a.bit.insert(a.bit.begin(), 0);
-	}
-
-	while (bit.size() < a.bit.size()) { // If lhs is shorter than a, increase lhs to the same length with leading zeros
-		bit.insert(bit.begin(), 0);
+	INTEGER_STATS_SCOPE(bitwise, std::max(mag.size(), rhs.mag.size()));
+	if (mag.size() < rhs.mag.size()) { // If lhs is shorter than rhs, increase lhs to the same length with leading zeros
+		mag.resize(rhs.mag.size(), 0);
 	}
 
-	for (size_t i = 0, n = bit.size(); i < n; ++i) { // Compares each entry and changes the lhs accordingly
-		bit[i] = bit[i] ^ a.bit[i];
+	if (!rhs.mag.empty()) { // Compares each entry and changes the lhs accordingly
+		limb_kernels().xor_n(&mag[0], &mag[0], rhs.mag.data(), rhs.mag.size());
 	}
 
 	(*this).clean_up(); //remove leading zeros
@@ -527,10 +932,25 @@ Integer& Integer::operator^=(const Integer& rhs) {
     @param increment the number of times to shift lhs left
 */
 Integer& Integer::operator<<=(const unsigned int& increment) {
-	for (size_t i = 0; i < increment; ++i) {
-		bit.push_back(0);
+	INTEGER_STATS_SCOPE(shift, mag.size());
+	if (mag.empty()) {
+		return (*this);
 	}
-	(*this).clean_up();
+	std::size_t limbs = increment / 64;
+	unsigned int bits = increment % 64;
+	if (bits != 0) {
+		limb carry = 0;
+		limb* m = mag.data();
+		for (std::size_t i = 0, n = mag.size(); i < n; ++i) {
+			limb next = m[i] >> (64 - bits);
+			m[i] = (m[i] << bits) | carry;
+			carry = next;
+		}
+		if (carry) {
+			mag.push_back(carry);
+		}
+	}
+	mag.insert(mag.begin(), limbs, 0);
 	return (*this);
 }
 
@@ -538,30 +958,65 @@ Integer& Integer::operator<<=(const unsigned int& increment) {
     @param increment the number of times to shift lhs right
 */
 Integer& Integer::operator>>=(const unsigned int& increment) {
-	for (size_t i = 0; i < increment; ++i) {
-		bit.pop_back();
+	INTEGER_STATS_SCOPE(shift, mag.size());
+	std::size_t limbs = increment / 64;
+	unsigned int bits = increment % 64;
+	if (limbs >= mag.size()) { // every bit is shifted out
+		mag.clear();
+		sign = 0;
+		return (*this);
+	}
+	mag.erase(mag.begin(), mag.begin() + limbs);
+	if (bits != 0) {
+		limb* m = mag.data();
+		for (std::size_t i = 0, n = mag.size(); i < n; ++i) {
+			limb next = (i + 1 < n) ? m[i + 1] : 0;
+			m[i] = (m[i] >> bits) | (next << (64 - bits));
+		}
 	}
 	(*this).clean_up();
 	return (*this);
 }
 
+/** Flips every bit of the magnitude (up to its leading one) and the sign
+    @return the negation of the implicit parameter
+*/
 Integer Integer::operator~() const {
+	INTEGER_STATS_SCOPE(bitwise, mag.size());
 	Integer a; // Copy the implicit parameter
-	a.bit = bit;
 	a.sign = !(sign);
+	if (mag.empty()) { // zero is a single 0 bit, which flips to 1
+		a.mag.push_back(1);
+		return a;
+	}
 
-	a.bit.flip();
+	a.mag.resize(mag.size());
+	limb* m = a.mag.data();
+	for (std::size_t i = 0, n = mag.size(); i < n; ++i) {
+		m[i] = ~mag[i];
+	}
+	unsigned int top_bits = 64 - __builtin_clzll(mag.back()); // bits used by the leading limb
+	if (top_bits < 64) {
+		a.mag.back() &= ((limb)1 << top_bits) - 1;
+	}
 	a.clean_up();
 	return a;
 }
 
-/** Removes leading zeros, if the number is not 0
+/** Removes leading zeros (and gives zero a positive sign)
 */
 void Integer::clean_up() {
-	for (size_t i = 0, n = bit.size(); i < n; ++i) {
-		if (bit[0] == 0 && bit.size() != 1) { //check if lhs has a leading zero (and isn't zero)
-			bit.erase(bit.begin()); //remove the zero
-		}
+	INTEGER_STATS_SCOPE(clean_up, mag.size());
+	const storage& limbs = mag; // reads without making shared limbs private (see IntegerCow.h)
+	std::size_t n = limbs.size();
+	while (n > 0 && limbs[n - 1] == 0) { //check if lhs has a leading zero
+		--n; //remove the zero
+	}
+	if (n != limbs.size()) {
+		mag.resize(n);
+	}
+	if (mag.empty()) {
+		sign = 0;
 	}
 }
 
@@ -570,8 +1025,39 @@ void Integer::clean_up() {
     @param b of type Integer
     @return a + b
 */
-Integer operator+(Integer a, const Integer& b) {
-	return a += b;
+Integer operator+(const Integer& a, const Integer& b) {
+	Integer c(a);
+	return c += b;
+}
+
+/** Adds a and b, reusing the storage of a
+    @param a expiring Integer
+    @param b of type Integer
+    @return a + b
+*/
+Integer operator+(Integer&& a, const Integer& b) {
+	a += b;
+	return std::move(a);
+}
+
+/** Adds a and b, reusing the storage of b
+    @param a of type Integer
+    @param b expiring Integer
+    @return a + b
+*/
+Integer operator+(const Integer& a, Integer&& b) {
+	b += a;
+	return std::move(b);
+}
+
+/** Adds a and b, reusing the storage of a
+    @param a expiring Integer
+    @param b expiring Integer
+    @return a + b
+*/
+Integer operator+(Integer&& a, Integer&& b) {
+	a += b;
+	return std::move(a);
 }
 
 /** Subtracts a and b; returns the result
@@ -579,8 +1065,39 @@ Integer operator+(Integer a, const Integer& b) {
     @param b of type Integer
     @return a - b
 */
-Integer operator-(Integer a, const Integer& b) {
-	return a -= b;
+Integer operator-(const Integer& a, const Integer& b) {
+	Integer c(a);
+	return c -= b;
+}
+
+/** Subtracts a and b, reusing the storage of a
+    @param a expiring Integer
+    @param b of type Integer
+    @return a - b
+*/
+Integer operator-(Integer&& a, const Integer& b) {
+	a -= b;
+	return std::move(a);
+}
+
+/** Subtracts a and b, reusing the storage of b: a - b == -(b - a)
+    @param a of type Integer
+    @param b expiring Integer
+    @return a - b
+*/
+Integer operator-(const Integer& a, Integer&& b) {
+	b -= a;
+	return -std::move(b);
+}
+
+/** Subtracts a and b, reusing the storage of a
+    @param a expiring Integer
+    @param b expiring Integer
+    @return a - b
+*/
+Integer operator-(Integer&& a, Integer&& b) {
+	a -= b;
+	return std::move(a);
 }
 
 /** Multiplies a and b; returns the result
@@ -588,8 +1105,40 @@ Integer operator-(Integer a, const Integer& b) {
     @param b
     @return a * b
 */
-Integer operator*(Integer a, const Integer& b) {
-	return a *= b;
+Integer operator*(const Integer& a, const Integer& b) {
+	Integer c;
+	addmul(c, a, b); // the product is written straight into c
+	return c;
+}
+
+/** Multiplies a and b, reusing the storage of a
+    @param a expiring Integer
+    @param b
+    @return a * b
+*/
+Integer operator*(Integer&& a, const Integer& b) {
+	a *= b;
+	return std::move(a);
+}
+
+/** Multiplies a and b, reusing the storage of b
+    @param a
+    @param b expiring Integer
+    @return a * b
+*/
+Integer operator*(const Integer& a, Integer&& b) {
+	b *= a;
+	return std::move(b);
+}
+
+/** Multiplies a and b, reusing the storage of a
+    @param a expiring Integer
+    @param b expiring Integer
+    @return a * b
+*/
+Integer operator*(Integer&& a, Integer&& b) {
+	a *= b;
+	return std::move(a);
 }
 
 /** Returns true if lhs != rhs (otherwise, false)
@@ -634,7 +1183,8 @@ bool operator>=(const Integer& lhs, const Integer& rhs) {
     @return a&b (bit-wise comparison)
 */
 Integer operator&(Integer a, const Integer& b){
-	return a &= b;
+	a &= b;
+	return a;
 }
 
 /** Returns the bit-wise result of a|b
@@ -643,7 +1193,8 @@ Integer operator&(Integer a, const Integer& b){
     @return a|b (bit-wise comparison)
 */
 Integer operator|(Integer a, const Integer& b) {
-	return a |= b;
+	a |= b;
+	return a;
 }
 
 /** Returns the bit-wise result of a^b
@@ -652,22 +1203,55 @@ Integer operator|(Integer a, const Integer& b) {
     @return a^b (bit-wise comparison)
 */
 Integer operator^(Integer a, const Integer& b) {
-	return a ^= b;
+	a ^= b;
+	return a;
 }
 
 /** Returns a shifted left increment number of times
-    @param a
+    @param a (a copy; the caller's value is not modified)
     @param increment
     @return a shifted left increment number of times
 */
-Integer operator<<(Integer& a, const unsigned int& increment) {
-	return a <<= increment;
+Integer operator<<(Integer a, const unsigned int& increment) {
+	a <<= increment;
+	return a;
 }
 /** Returns a shifted right increment number of times
-    @param a
+    @param a (a copy; the caller's value is not modified)
     @param increment
     @return a shifted right increment number of times
 */
-Integer operator>>(Integer& a, const unsigned int& increment) {
-	return (a >>= increment);
-}
\ No newline at end of file
+Integer operator>>(Integer a, const unsigned int& increment) {
+	a >>= increment;
+	return a;
+}
+
+/** Returns the operand size from which products use Karatsuba's method instead of the schoolbook method
+	@return number of limbs of the smaller operand
+*/
+std::size_t karatsuba_threshold() {
+	return karatsuba_limbs().load(std::memory_order_relaxed);
+}
+
+/** Changes the operand size from which products use Karatsuba's method (e.g. to tune it for a machine)
+	@param limbs number of limbs of the smaller operand (at least 2; 0 restores the default)
+*/
+void set_karatsuba_threshold(std::size_t limbs) {
+	karatsuba_limbs().store(limbs == 0 ? threshold_from_environment("INTEGER_KARATSUBA", 24) : std::max(limbs, (std::size_t)2),
+		std::memory_order_relaxed);
+}
+
+/** Returns the operand size from which products use number theoretic transforms (see IntegerNTT.h)
+	@return number of limbs of the smaller operand
+*/
+std::size_t ntt_threshold() {
+	return ntt_limbs().load(std::memory_order_relaxed);
+}
+
+/** Changes the operand size from which products use number theoretic transforms
+	@param limbs number of limbs of the smaller operand (at least 2; 0 restores the default)
+*/
+void set_ntt_threshold(std::size_t limbs) {
+	ntt_limbs().store(limbs == 0 ? threshold_from_environment("INTEGER_NTT", 5000) : std::max(limbs, (std::size_t)2),
+		std::memory_order_relaxed);
+}
@@ -6,6 +6,9 @@
 	Positive and negative integer types are stored as objects of a class Integer so that they can be:
 	1. added, subtracted, or multiplied:	a + b; a - b; a * b;
 	1a.										a += b; a -= b; a *= b;
+											a.mul_limb(y);
+	1b. fused multiply-add:					addmul(acc, x, y); submul(acc, x, y);
+											addmul_limb(acc, x, y); submul_limb(acc, x, y);
 	2. incremented:							++a; a++; --a; a--;
 	3. shifted:								a << increment; a >> increment;
 	3a.										a <<= increment; a >>= increment;
@@ -14,49 +17,105 @@
 	6. compared bitwise:					a & b; a | b; a ^ b;
 	6a.										a &= b; a |= b; a ^= b;
 	7. displayed in base 10 or base 2:		a.print_as_int(); a.print_as_bits();
+	8. instrumented (optional):				see IntegerStats.h
 
 	Additional useful variations of the above are also included.
+
+	Products of operands of karatsuba_threshold() limbs or more use Karatsuba's method (O(n^1.58) instead of
+	O(n^2)), and from ntt_threshold() limbs number theoretic transforms (O(n log n); see IntegerNTT.h). The
+	thresholds can be tuned with set_karatsuba_threshold and set_ntt_threshold, or with the environment
+	variables INTEGER_KARATSUBA and INTEGER_NTT.
+
+	Integers are values: copying one copies its limbs. With INTEGER_COW defined (for the whole program, e.g.
+	cmake -DINTEGER_COW=ON), copies share their limbs instead until one of them is changed, so that passing
+	and returning large Integers by value costs O(1); see IntegerCow.h.
+
+	Binary operators have overloads for expiring (rvalue) operands, so an expression such as
+	-((n - 1)*s(k, n - 1)) + s(k - 1, n - 1) reuses the storage of its temporaries instead of copying them.
+	Defining INTEGER_EXPRESSION_TEMPLATES before including this file makes a + b, a - b and a * b lazy
+	instead; see IntegerExpr.h.
 */
 
 #ifndef INTEGER_H
 #define INTEGER_H
 
+#include "IntegerStats.h"
+#ifdef INTEGER_COW
+#include "IntegerCow.h"
+#endif
+#include <cstddef>
+#include <iosfwd>
 #include <vector>
 
+class IntegerView; // see IntegerTable.h
+
 /** @class Integer
-	@brief Stores an integer value using a collection of bits and a reserved signed bit.
+	@brief Stores an integer value using a collection of limbs and a reserved signed bit.
 
-Stores integer values as vectors of type bool, using the sign and magnitude format. (The sign is stored separately).
+Stores integer values as vectors of 64-bit limbs (least significant limb first), using the sign and magnitude format.
+(The sign is stored separately). Zero is stored as an empty magnitude with a positive sign.
 See file description (above) for possible manipulations of Integer type variables.
 
 */
 class Integer {
 public:
+	typedef unsigned long long limb; // One base 2^64 digit of the magnitude
+#ifdef INTEGER_COW
+	typedef CowStorage<limb, IntegerAllocator<limb> > storage; // Limb storage, shared by copies until one changes (see IntegerCow.h)
+#else
+	typedef std::vector<limb, IntegerAllocator<limb> > storage; // Limb storage (counted when INTEGER_STATS is on)
+#endif
+
 	friend std::ostream& operator<<(std::ostream& out, const Integer& i);
 	friend std::istream& operator>>(std::istream& in, Integer& i);
+	friend void write_binary(std::ostream& out, const Integer& value); // Writes value in binary (e.g. for checkpoints)
+	friend bool read_binary(std::istream& in, Integer& value);		 // Reads a value written by write_binary
+
+	friend void addmul(Integer& acc, const Integer& x, const Integer& y); // acc += x*y without temporaries
+	friend void submul(Integer& acc, const Integer& x, const Integer& y); // acc -= x*y without temporaries
+	friend void addmul_limb(Integer& acc, const Integer& x, limb y);		 // acc += x*y for a single limb y
+	friend void submul_limb(Integer& acc, const Integer& x, limb y);		 // acc -= x*y for a single limb y
+	friend Integer& operator+=(Integer& lhs, const IntegerView& value); // lhs += a view (e.g. a cell of an IntegerTable)
+	friend Integer& operator-=(Integer& lhs, const IntegerView& value); // lhs -= a view
 
 	// Constructors
 	Integer();		// Defaults to zero
 	Integer(int a); // Converts int to binary
+	static Integer from_limb(limb a); // Converts a single (unsigned 64-bit) limb
+	static Integer from_limbs(const limb* limbs, std::size_t n, bool negative); // Copies a magnitude of n limbs (least significant first)
+	Integer(const Integer& other) = default;	// Copies the limbs of other (shares them with INTEGER_COW)
+	Integer(Integer&& other) noexcept;			// Takes the limbs of other, which is left as zero
+
+	Integer& operator=(const Integer& other) = default; // Copies other into lhs (reuses the storage of lhs; shares with INTEGER_COW)
+	Integer& operator=(Integer&& other) noexcept;		  // Swaps limbs with other, which keeps the old storage of lhs
+	void copy_from(const Integer& other);				  // Copies the limbs of other into the storage of lhs (never shares them)
 
 	// Mutators
 	Integer& operator+=(const Integer& value); // Adds value to lhs and returns lhs
 	Integer& operator-=(const Integer& value); // Subtracts value from lhs and returns lhs
 	Integer& operator*=(const Integer& value); // Multiplies value to lhs and returns lhs
 	//TODO: dividing Integers (for use in fraction class)
+	limb divide_limb(limb d);		 // Divides the magnitude of lhs by d (keeping the sign) and returns the remainder
+	Integer& mul_limb(limb y);		 // Multiplies lhs by y in place and returns lhs (y = 0 gives zero)
+	void reserve(std::size_t limbs); // Reserves storage for a magnitude of limbs limbs
 
 	Integer& operator++();			// Prefix increment
 	Integer operator++(int unused); // Postfix increment
 	Integer& operator--();			// Prefix decrement
 	Integer operator--(int unused);	// Postfix decrement
 
-	Integer operator-() const; // -a: flips the sign of a
-	Integer operator+() const; // +a: returns a copy of a
-	Integer abs() const;       // |a|: takes the magnitude of a
+	Integer operator-() const &; // -a: flips the sign of a copy of a
+	Integer operator-() &&;		 // -a: flips the sign of an expiring a in place
+	Integer operator+() const;	 // +a: returns a copy of a
+	Integer abs() const;		 // |a|: takes the magnitude of a
 
 	// Accessors
 	void print_as_int(std::ostream& out) const;  // Prints the lhs in base 10
+	static void print_as_int(std::ostream& out, const limb* limbs, std::size_t n, bool negative); // Prints a magnitude of n limbs in base 10
 	void print_as_bits(std::ostream& out) const; // Prints the lhs in base 2
+	std::size_t size() const;					 // Number of limbs in the magnitude of lhs (zero has none)
+	const limb* limbs() const;					 // The size() limbs of the magnitude, least significant first
+	bool negative() const;						 // True if lhs < 0
 
 	// Comparisons
 	bool operator<(const Integer& rhs) const;	// True if lhs < rhs
@@ -74,14 +133,38 @@ public:
 
 private:
 	void clean_up(); // Removes leading zeros
+	void add_magnitude(const limb* b, std::size_t bn, bool b_sign); // lhs += (+/-)b, b must not alias lhs
+	static void add_product(Integer& acc, const Integer& x, const Integer& y, bool negate); // acc += (+/-)x*y (any aliasing)
+	static void add_product_limb(Integer& acc, const Integer& x, limb y, bool negate); // acc += (+/-)x*y for one limb y
 
-	std::vector<bool> bit;
+	storage mag; // magnitude, least significant limb first, without leading zero limbs
 	bool sign; // zero is positive; 1 indicates negative
 };
 
-Integer operator+(Integer a, const Integer& b); // Adds a + b
-Integer operator-(Integer a, const Integer& b); // Subtracts a - b
-Integer operator*(Integer a, const Integer& b); // Multiplies a * b
+std::ostream& operator<<(std::ostream& out, const Integer& i); // Prints i in base 10
+std::istream& operator>>(std::istream& in, Integer& i);		  // Reads i in base 10
+void write_binary(std::ostream& out, const Integer& value); // Writes value in binary: one word (limbs*2 + sign), then the limbs
+bool read_binary(std::istream& in, Integer& value);		 // Reads a value written by write_binary (false if the input is cut short)
+
+#ifndef INTEGER_EXPRESSION_TEMPLATES
+Integer operator+(const Integer& a, const Integer& b); // Adds a + b
+Integer operator+(Integer&& a, const Integer& b);	   // Adds a + b (reuses a)
+Integer operator+(const Integer& a, Integer&& b);	   // Adds a + b (reuses b)
+Integer operator+(Integer&& a, Integer&& b);		   // Adds a + b (reuses a)
+Integer operator-(const Integer& a, const Integer& b); // Subtracts a - b
+Integer operator-(Integer&& a, const Integer& b);	   // Subtracts a - b (reuses a)
+Integer operator-(const Integer& a, Integer&& b);	   // Subtracts a - b (reuses b)
+Integer operator-(Integer&& a, Integer&& b);		   // Subtracts a - b (reuses a)
+Integer operator*(const Integer& a, const Integer& b); // Multiplies a * b
+Integer operator*(Integer&& a, const Integer& b);	   // Multiplies a * b (reuses a)
+Integer operator*(const Integer& a, Integer&& b);	   // Multiplies a * b (reuses b)
+Integer operator*(Integer&& a, Integer&& b);		   // Multiplies a * b (reuses a)
+#endif
+
+void addmul(Integer& acc, const Integer& x, const Integer& y); // acc += x*y without temporaries
+void submul(Integer& acc, const Integer& x, const Integer& y); // acc -= x*y without temporaries
+void addmul_limb(Integer& acc, const Integer& x, Integer::limb y); // acc += x*y for a single limb y
+void submul_limb(Integer& acc, const Integer& x, Integer::limb y); // acc -= x*y for a single limb y
 
 bool operator!=(const Integer& lhs, const Integer& rhs); // True if lhs != rhs
 bool operator>(const Integer& lhs, const Integer& rhs);  // True if lhs > rhs
@@ -92,8 +175,17 @@ Integer operator&(Integer a, const Integer& b); // And: returns result of a&b (b
 Integer operator|(Integer a, const Integer& b); // Or:  returns result of a|b (bitwise)
 Integer operator^(Integer a, const Integer& b); // Xor: returns result of a^b (bitwise)
 
-Integer operator<<(Integer& a, const unsigned int& increment); // Returns a shifted up increment number of times
-Integer operator>>(Integer& a, const unsigned int& increment); // Returns a shifted down increment number of times
+Integer operator<<(Integer a, const unsigned int& increment); // Returns a shifted up increment number of times
+Integer operator>>(Integer a, const unsigned int& increment); // Returns a shifted down increment number of times
+
+std::size_t karatsuba_threshold();				 // Operand size (limbs) from which products use Karatsuba's method
+void set_karatsuba_threshold(std::size_t limbs); // Sets it (0: INTEGER_KARATSUBA from the environment, or 24)
+std::size_t ntt_threshold();					 // Operand size (limbs) from which products use number theoretic transforms
+void set_ntt_threshold(std::size_t limbs);		 // Sets it (0: INTEGER_NTT from the environment, or 5000)
+
 
+#ifdef INTEGER_EXPRESSION_TEMPLATES
+#include "IntegerExpr.h" // a + b, a - b and a * b build expression trees (see IntegerExpr.h)
+#endif
 
 #endif //Ends the include guard
\ No newline at end of file
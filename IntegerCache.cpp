@@ -0,0 +1,406 @@
+/** @file IntegerCache.cpp
+	@brief Sharded concurrent memo of Integer values (see IntegerCache.h)
+
+Each shard has a fixed array of chains. An entry is linked at the head of its chain (under the shard lock)
+with its key already set, so a reader that walks the chain with atomic loads sees either the whole entry or
+none of it. The value of an entry is written once, before its ready flag is set (release), and never changed
+afterwards, so a reader that sees ready (acquire) can copy the value without a lock.
+
+Unlinking an entry (eviction, or a failed computation) does not free it: a reader may be standing on it. The
+entry goes to the retired list of the shard, tagged with the epoch of the shard, and is freed once every reader
+that could have reached it has left. A reader increments the count of the current epoch's parity before it loads
+the head of a chain (and starts again if the epoch changed in between), and reclaim reads the counts after the
+entries are out of their chains (all sequentially consistent). When the count of the previous epoch is zero,
+every reader that registered in an epoch before the current one has left: the entries retired before the
+current epoch are freed, and the epoch advances (its new previous count is the one just found to be zero, and
+the readers counted in the former current one must leave before the next advance). New readers only ever
+register in the current epoch, so the count being waited for drains even if the shard always has readers.
+Threads waiting for a pending entry keep it alive with a count of their own (waiters).
+*/
+
+#include "IntegerCache.h"
+#include <algorithm>
+#include <utility>
+
+typedef Integer::limb limb;
+
+/** @class IntegerCache::Entry
+	@brief One cached value, or a value still being computed (pending)
+*/
+struct IntegerCache::Entry {
+	explicit Entry(std::uint64_t key) : key(key) {}
+
+	const std::uint64_t key;			 // (k, n)
+	std::atomic<Entry*> next{nullptr};	 // next entry of the chain
+	std::atomic<bool> ready{false};		 // the value is stored (it is pending until then)
+	std::atomic<bool> referenced{false}; // read since the clock hand last passed (CLOCK)
+	Integer value;						 // set once, before ready
+	std::uint64_t retired_epoch = 0;	 // epoch of the shard when the entry was unlinked
+	std::size_t bytes = sizeof(Entry);	 // memory charged to the shard
+	std::size_t waiters = 0;			 // threads waiting for the value (shard locked)
+	bool failed = false;				 // the computation threw: waiters compute the value themselves
+};
+
+/** @class IntegerCache::Shard
+	@brief The chains of one part of the key space, with their lock, clock and counters
+*/
+struct IntegerCache::Shard {
+	std::mutex lock;					 // held to link, unlink, store and evict
+	std::condition_variable completed;	 // signalled when a pending entry is stored or abandoned
+	std::atomic<std::uint64_t> epoch{1}; // advanced by reclaim (under the lock)
+	std::atomic<std::size_t> readers[2] = {}; // lock-free readers walking a chain, by the parity of their epoch
+	std::unique_ptr<std::atomic<Entry*>[]> buckets; // heads of the chains
+	std::vector<Entry*> clock;			 // ready entries, in no particular order
+	std::size_t hand = 0;				 // next entry of the clock to consider for eviction
+	std::vector<Entry*> retired;		 // unlinked entries not yet freed
+	std::atomic<std::size_t> bytes{0};	 // memory of the linked entries
+	std::atomic<std::uint64_t> hits{0}, misses{0}, waits{0}, evictions{0};
+
+	/** Registers a lock-free reader, before it loads the head of a chain
+		@return its parity (for leave)
+	*/
+	std::size_t enter() {
+		for (;;) {
+			std::uint64_t current = epoch.load();
+			readers[current & 1].fetch_add(1);
+			if (epoch.load() == current) {
+				return current & 1;
+			}
+			readers[current & 1].fetch_sub(1); // the epoch advanced meanwhile: registers in the new one
+		}
+	}
+
+	/** Unregisters a reader that has left the chains
+		@param parity returned by enter
+	*/
+	void leave(std::size_t parity) {
+		readers[parity].fetch_sub(1);
+	}
+};
+
+namespace {
+
+/** Packs (k, n) into one key
+*/
+std::uint64_t make_key(int k, int n) {
+	return ((std::uint64_t)(std::uint32_t)k << 32) | (std::uint32_t)n;
+}
+
+/** Mixes the bits of a key (Fibonacci hashing): the top bits pick the shard, the next ones the chain
+*/
+std::uint64_t hash(std::uint64_t key) {
+	key ^= key >> 29;
+	return key * 0x9E3779B97F4A7C15ULL;
+}
+
+}
+
+/** Constructor of IntegerCache
+	@param budget bytes that the values may take (each shard gets an equal share)
+*/
+IntegerCache::IntegerCache(std::size_t budget) : shards(new Shard[(std::size_t)1 << shard_bits]) {
+	const std::size_t shard_count = (std::size_t)1 << shard_bits;
+	shard_budget = std::max<std::size_t>(budget / shard_count, 1);
+	bucket_bits = 4; // about one chain per 256 bytes of budget, from 16 to 2^20 per shard
+	while (bucket_bits < 20 && ((std::size_t)256 << bucket_bits) < shard_budget) {
+		++bucket_bits;
+	}
+	for (std::size_t i = 0; i < shard_count; ++i) {
+		shards[i].buckets.reset(new std::atomic<Entry*>[(std::size_t)1 << bucket_bits]);
+		for (std::size_t b = 0; b < ((std::size_t)1 << bucket_bits); ++b) {
+			shards[i].buckets[b].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+}
+
+/** Destructor of IntegerCache
+*/
+IntegerCache::~IntegerCache() {
+	clear();
+}
+
+/** Returns f(k, n): the cached value, or the value that another thread is computing, or else compute()
+	(which is then cached). compute may call get again for other cells (recursion), but not for (k, n).
+	@param k first input
+	@param n second input
+	@param compute computes f(k, n) when it is not cached
+	@return f(k, n)
+*/
+Integer IntegerCache::get(int k, int n, const std::function<Integer()>& compute) {
+	Integer value;
+	if (find(k, n, value)) {
+		return value;
+	}
+
+	const std::uint64_t key = make_key(k, n);
+	Shard& shard = shard_of(key);
+	std::atomic<Entry*>& bucket = bucket_of(shard, key);
+	Entry* entry;
+	{
+		std::unique_lock<std::mutex> guard(shard.lock);
+		for (;;) {
+			entry = find_in_chain(bucket, key);
+			if (entry == nullptr) { // nobody has it: this thread computes it
+				entry = link(shard, bucket, key);
+				shard.misses.fetch_add(1, std::memory_order_relaxed);
+				break;
+			}
+			if (!entry->ready.load(std::memory_order_acquire)) { // pending: waits for the thread computing it
+				shard.waits.fetch_add(1, std::memory_order_relaxed);
+				++entry->waiters;
+				shard.completed.wait(guard, [entry] { return entry->ready.load(std::memory_order_acquire) || entry->failed; });
+				--entry->waiters;
+				if (entry->failed) { // looks again (it is no longer in the chain)
+					reclaim(shard);
+					continue;
+				}
+			}
+			else {
+				shard.hits.fetch_add(1, std::memory_order_relaxed);
+			}
+			entry->referenced.store(true, std::memory_order_relaxed);
+			value = entry->value; // the entry stays allocated while the lock is held (or it has waiters)
+			reclaim(shard);
+			return value;
+		}
+	}
+
+	try {
+		value = compute();
+	}
+	catch (...) {
+		abandon(shard, entry);
+		throw;
+	}
+	store(shard, entry, value);
+	return value;
+}
+
+/** Looks up f(k, n) without taking a lock
+	@param value receives f(k, n) if it is cached
+	@return true if f(k, n) is cached (false if it is missing or still being computed)
+*/
+bool IntegerCache::find(int k, int n, Integer& value) const {
+	const std::uint64_t key = make_key(k, n);
+	Shard& shard = shard_of(key);
+	std::size_t parity = shard.enter();
+	Entry* entry = find_in_chain(bucket_of(shard, key), key);
+	bool found = entry != nullptr && entry->ready.load(std::memory_order_acquire);
+	if (found) {
+		value = entry->value;
+		entry->referenced.store(true, std::memory_order_relaxed);
+		shard.hits.fetch_add(1, std::memory_order_relaxed);
+	}
+	shard.leave(parity);
+	return found;
+}
+
+/** Tells whether f(k, n) is cached, without taking a lock or copying the value
+	@return true if f(k, n) is cached (false if it is missing or still being computed)
+*/
+bool IntegerCache::contains(int k, int n) const {
+	const std::uint64_t key = make_key(k, n);
+	Shard& shard = shard_of(key);
+	std::size_t parity = shard.enter();
+	Entry* entry = find_in_chain(bucket_of(shard, key), key);
+	bool found = entry != nullptr && entry->ready.load(std::memory_order_acquire);
+	shard.leave(parity);
+	return found;
+}
+
+/** Caches a value of f(k, n) obtained elsewhere (e.g. kept by the caller after it was evicted), as if it had
+	been computed; nothing changes if f(k, n) is cached or being computed
+	@param k first input
+	@param n second input
+	@param value f(k, n)
+*/
+void IntegerCache::put(int k, int n, const Integer& value) {
+	const std::uint64_t key = make_key(k, n);
+	Shard& shard = shard_of(key);
+	std::atomic<Entry*>& bucket = bucket_of(shard, key);
+	Entry* entry;
+	{
+		std::lock_guard<std::mutex> guard(shard.lock);
+		if (find_in_chain(bucket, key) != nullptr) {
+			return;
+		}
+		entry = link(shard, bucket, key);
+	}
+	store(shard, entry, value);
+}
+
+/** Returns the number of cached values
+*/
+std::size_t IntegerCache::size() const {
+	std::size_t count = 0;
+	for (std::size_t i = 0; i < ((std::size_t)1 << shard_bits); ++i) {
+		std::lock_guard<std::mutex> guard(shards[i].lock);
+		count += shards[i].clock.size();
+	}
+	return count;
+}
+
+/** Returns the bytes held by the cached values (and by the entries being computed)
+*/
+std::size_t IntegerCache::memory() const {
+	std::size_t bytes = 0;
+	for (std::size_t i = 0; i < ((std::size_t)1 << shard_bits); ++i) {
+		bytes += shards[i].bytes.load(std::memory_order_relaxed);
+	}
+	return bytes;
+}
+
+/** Returns the hits, misses, waits and evictions so far
+*/
+IntegerCache::Statistics IntegerCache::statistics() const {
+	Statistics total = { 0, 0, 0, 0 };
+	for (std::size_t i = 0; i < ((std::size_t)1 << shard_bits); ++i) {
+		total.hits += shards[i].hits.load(std::memory_order_relaxed);
+		total.misses += shards[i].misses.load(std::memory_order_relaxed);
+		total.waits += shards[i].waits.load(std::memory_order_relaxed);
+		total.evictions += shards[i].evictions.load(std::memory_order_relaxed);
+	}
+	return total;
+}
+
+/** Removes every value; no other thread may use the cache while it runs
+*/
+void IntegerCache::clear() {
+	for (std::size_t i = 0; i < ((std::size_t)1 << shard_bits); ++i) {
+		Shard& shard = shards[i];
+		for (std::size_t b = 0; b < ((std::size_t)1 << bucket_bits); ++b) {
+			for (Entry* entry = shard.buckets[b].load(); entry != nullptr; ) {
+				Entry* next = entry->next.load();
+				delete entry;
+				entry = next;
+			}
+			shard.buckets[b].store(nullptr);
+		}
+		for (Entry* entry : shard.retired) {
+			delete entry;
+		}
+		shard.retired.clear();
+		shard.clock.clear();
+		shard.hand = 0;
+		shard.bytes = 0;
+	}
+}
+
+/** Returns the shard that holds key
+*/
+IntegerCache::Shard& IntegerCache::shard_of(std::uint64_t key) const {
+	return shards[hash(key) >> (64 - shard_bits)];
+}
+
+/** Returns the head of the chain that holds key
+*/
+std::atomic<IntegerCache::Entry*>& IntegerCache::bucket_of(Shard& shard, std::uint64_t key) const {
+	return shard.buckets[(hash(key) << shard_bits) >> (64 - bucket_bits)];
+}
+
+/** Adds a pending entry for key at the head of its chain; the shard lock must be held
+	@return the entry
+*/
+IntegerCache::Entry* IntegerCache::link(Shard& shard, std::atomic<Entry*>& bucket, std::uint64_t key) {
+	Entry* entry = new Entry(key);
+	entry->next.store(bucket.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	bucket.store(entry, std::memory_order_release);
+	shard.bytes += entry->bytes;
+	return entry;
+}
+
+/** Finds the entry of key in a chain (sequentially consistent loads, see reclaim)
+	@return the entry, or nullptr
+*/
+IntegerCache::Entry* IntegerCache::find_in_chain(const std::atomic<Entry*>& head, std::uint64_t key) {
+	for (Entry* entry = head.load(); entry != nullptr; entry = entry->next.load()) {
+		if (entry->key == key) {
+			return entry;
+		}
+	}
+	return nullptr;
+}
+
+/** Stores the computed value of a pending entry, wakes its waiters and evicts to stay within the budget
+	@param entry pending entry linked by this thread
+	@param value its value
+*/
+void IntegerCache::store(Shard& shard, Entry* entry, const Integer& value) {
+	{
+		std::lock_guard<std::mutex> guard(shard.lock);
+		entry->value = value;
+		std::size_t limbs = entry->value.size() * sizeof(limb);
+		entry->bytes += limbs;
+		shard.bytes += limbs;
+		entry->referenced.store(true, std::memory_order_relaxed);
+		entry->ready.store(true, std::memory_order_release);
+		shard.clock.push_back(entry);
+		evict(shard);
+		reclaim(shard);
+	}
+	shard.completed.notify_all();
+}
+
+/** Removes a pending entry whose computation threw, and wakes its waiters (which then compute it themselves)
+	@param entry pending entry linked by this thread
+*/
+void IntegerCache::abandon(Shard& shard, Entry* entry) {
+	{
+		std::lock_guard<std::mutex> guard(shard.lock);
+		unlink(shard, entry);
+		entry->failed = true;
+		shard.bytes -= entry->bytes;
+		shard.retired.push_back(entry);
+		reclaim(shard);
+	}
+	shard.completed.notify_all();
+}
+
+/** Takes entry out of its chain; the shard lock must be held
+*/
+void IntegerCache::unlink(Shard& shard, Entry* entry) {
+	std::atomic<Entry*>* link = &bucket_of(shard, entry->key);
+	while (link->load(std::memory_order_relaxed) != entry) {
+		link = &link->load(std::memory_order_relaxed)->next;
+	}
+	link->store(entry->next.load(std::memory_order_relaxed)); // sequentially consistent (see reclaim)
+	entry->retired_epoch = shard.epoch.load(std::memory_order_relaxed);
+}
+
+/** Evicts ready entries by the CLOCK rule until the shard is within its budget; the shard lock must be held
+*/
+void IntegerCache::evict(Shard& shard) {
+	while (shard.bytes.load(std::memory_order_relaxed) > shard_budget && !shard.clock.empty()) {
+		if (shard.hand >= shard.clock.size()) {
+			shard.hand = 0;
+		}
+		Entry* entry = shard.clock[shard.hand];
+		if (entry->referenced.exchange(false, std::memory_order_relaxed)) { // a second chance
+			++shard.hand;
+			continue;
+		}
+		unlink(shard, entry);
+		shard.clock[shard.hand] = shard.clock.back(); // the hand stays, so the moved entry is considered next
+		shard.clock.pop_back();
+		shard.bytes -= entry->bytes;
+		shard.retired.push_back(entry);
+		shard.evictions.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+/** Frees the entries retired before the current epoch (except those with waiters) and advances the epoch, once
+	the readers of the previous epoch have left (see the file description); the shard lock must be held
+*/
+void IntegerCache::reclaim(Shard& shard) {
+	std::uint64_t current = shard.epoch.load(std::memory_order_relaxed);
+	if (shard.retired.empty() || shard.readers[(current - 1) & 1].load() != 0) {
+		return;
+	}
+	std::vector<Entry*>::iterator kept = std::partition(shard.retired.begin(), shard.retired.end(),
+		[current](const Entry* entry) { return entry->waiters != 0 || entry->retired_epoch == current; });
+	for (std::vector<Entry*>::iterator i = kept; i != shard.retired.end(); ++i) {
+		delete *i;
+	}
+	shard.retired.erase(kept, shard.retired.end());
+	shard.epoch.store(current + 1); // the entries retired in current are freed after the next advance
+}
@@ -0,0 +1,88 @@
+/** @file IntegerCache.h
+	@brief A concurrent memo of Integer values keyed on (k, n), with a memory budget, for recursive functions
+
+	IntegerCache remembers f(k, n) for a recursive function f (e.g. p, s and S in main.cpp), so that each cell
+	is computed once however often the recursion reaches it:
+	IntegerCache cache(budget);
+	Integer value = cache.get(k, n, [&]() -> Integer { return f(k, n - 1) + ...; });
+	Any number of threads may call get at the same time, on the same or on different cells:
+	1. A hit reads the cell without taking a lock (the cells are in linked chains of atomic pointers).
+	2. A miss locks the shard of the cell, records the cell as pending and computes it without the lock.
+	   Other threads that ask for a pending cell wait for that computation instead of repeating it.
+	3. When the value is stored, cells of the shard are evicted by the CLOCK rule (a hit marks a cell, and the
+	   clock hand spares a marked cell once) until the shard is within its share of the budget.
+	The cells are spread over 64 shards by a hash of the key. An evicted cell is freed once every lock-free
+	reader of its shard that started before the eviction has finished, since such a reader may still be looking
+	at it (readers that start later cannot reach it, so a shard that always has readers still frees its cells).
+
+	A recursion whose cells all fit in the budget computes each cell once. With a smaller budget it still
+	gives the right values, but an evicted cell that is needed again is computed again, unless the caller kept
+	it and stores it back with put (as the bottom-up fill of compute_cells in main.cpp does).
+*/
+
+#ifndef INTEGER_CACHE_H
+#define INTEGER_CACHE_H
+
+#include "Integer.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/** @class IntegerCache
+	@brief Thread-safe memo of f(k, n) with a memory budget (see file description)
+*/
+class IntegerCache {
+public:
+	/** @class Statistics
+		@brief Counts of what the lookups did
+	*/
+	struct Statistics {
+		std::uint64_t hits;		 // lookups answered from the cache
+		std::uint64_t misses;	 // values computed
+		std::uint64_t waits;	 // lookups that waited for another thread's computation
+		std::uint64_t evictions; // values evicted to stay within the budget
+	};
+
+	static const std::size_t default_budget = (std::size_t)1 << 30; // bytes (1 GiB)
+
+	explicit IntegerCache(std::size_t budget = default_budget); // Empty cache holding at most about budget bytes
+	~IntegerCache();
+	IntegerCache(const IntegerCache&) = delete;
+	IntegerCache& operator=(const IntegerCache&) = delete;
+
+	Integer get(int k, int n, const std::function<Integer()>& compute); // f(k, n), from compute() on a miss
+	bool find(int k, int n, Integer& value) const; // Copies f(k, n) into value if it is cached (never waits)
+	bool contains(int k, int n) const; // Whether f(k, n) is cached (never waits; not counted as a hit)
+	void put(int k, int n, const Integer& value); // Caches f(k, n) = value, unless it is cached or being computed
+
+	std::size_t size() const;		 // Number of cached values
+	std::size_t memory() const;		 // Bytes held by the cached values
+	Statistics statistics() const;	 // Hits, misses, waits and evictions so far
+	void clear();					 // Removes every value (no other thread may use the cache meanwhile)
+
+private:
+	struct Entry;
+	struct Shard;
+
+	static Entry* find_in_chain(const std::atomic<Entry*>& head, std::uint64_t key); // The entry of key, or nullptr
+	Shard& shard_of(std::uint64_t key) const;		   // The shard that holds key
+	std::atomic<Entry*>& bucket_of(Shard& shard, std::uint64_t key) const; // The chain that holds key
+	Entry* link(Shard& shard, std::atomic<Entry*>& bucket, std::uint64_t key); // Adds a pending entry (shard locked)
+	void store(Shard& shard, Entry* entry, const Integer& value); // Completes a pending entry
+	void abandon(Shard& shard, Entry* entry);		   // Removes a pending entry whose computation failed
+	void unlink(Shard& shard, Entry* entry);		   // Takes entry out of its chain (shard locked)
+	void evict(Shard& shard);						   // Evicts values until the shard is within its budget
+	void reclaim(Shard& shard);						   // Frees the unlinked entries that no thread can reach
+
+	static const unsigned shard_bits = 6; // 64 shards
+	std::size_t shard_budget;			  // bytes per shard
+	unsigned bucket_bits;				  // log2 of the number of chains per shard
+	std::unique_ptr<Shard[]> shards;
+};
+
+#endif //Ends the include guard
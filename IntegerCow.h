@@ -0,0 +1,214 @@
+/** @file IntegerCow.h
+	@brief Copy-on-write limb storage: copies of an Integer share one buffer until one of them changes
+
+	With INTEGER_COW defined (for the whole program, e.g. cmake -DINTEGER_COW=ON), Integer::storage is a
+	CowStorage instead of a std::vector. A CowStorage is one pointer to a block holding a reference count, the
+	size, the capacity and the elements. Copying it only increments the count (atomically, so that copies may
+	be shared between threads), which makes passing an Integer by value, returning it from a memo (see
+	IntegerCache.h) or copying it at the top of a compound operator O(1) instead of O(size).
+
+	The block is immutable while it is shared. Every non-const member (data(), operator[], resize, push_back,
+	...) first makes the block private: if other copies share it, the elements are copied into a new block of
+	this object's own, and the reference to the shared block is dropped. A pointer or reference obtained from a
+	non-const member is therefore valid only until the object is copied (as is the case with std::string in
+	copy-on-write implementations); Integer only uses them within one operation.
+
+	clear() on a shared block drops the reference without copying, so a buffer that is about to be overwritten
+	(e.g. the scratch buffer of a product) should be cleared before it is resized.
+*/
+
+#ifndef INTEGER_COW_H
+#define INTEGER_COW_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <utility>
+
+/** @class CowStorage
+	@brief A std::vector-like sequence of trivially copyable elements with shared, copy-on-write blocks
+	(see file description)
+*/
+template <class T, class Allocator>
+class CowStorage {
+public:
+	typedef T value_type;
+	typedef std::size_t size_type;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
+	CowStorage() : block(nullptr) {}
+	explicit CowStorage(std::size_t n, const T& value = T()) : block(nullptr) { resize(n, value); }
+	template <class Iterator>
+	CowStorage(Iterator first, Iterator last) : block(nullptr) { assign(first, last); }
+	CowStorage(const CowStorage& other) : block(other.block) { share(); }
+	CowStorage(CowStorage&& other) noexcept : block(other.block) { other.block = nullptr; }
+	~CowStorage() { release(); }
+
+	/** Shares the block of other
+	*/
+	CowStorage& operator=(const CowStorage& other) {
+		if (block != other.block) {
+			other.share();
+			release();
+			block = other.block;
+		}
+		return *this;
+	}
+
+	/** Takes the block of other, which is left empty
+	*/
+	CowStorage& operator=(CowStorage&& other) noexcept {
+		if (this != &other) {
+			release();
+			block = other.block;
+			other.block = nullptr;
+		}
+		return *this;
+	}
+
+	// Read access: never copies
+	std::size_t size() const { return block ? block->size : 0; }
+	bool empty() const { return size() == 0; }
+	std::size_t capacity() const { return block ? block->capacity : 0; }
+	const T* data() const { return block ? elements(block) : nullptr; }
+	const T& operator[](std::size_t i) const { return data()[i]; }
+	const T& back() const { return data()[size() - 1]; }
+	const T* begin() const { return data(); }
+	const T* end() const { return data() + size(); }
+	std::size_t use_count() const { return block ? block->references.load(std::memory_order_relaxed) : 0; } // Copies sharing the block
+
+	// Write access: makes the block private first
+	T* data() { make_private(capacity()); return block ? elements(block) : nullptr; }
+	T& operator[](std::size_t i) { return data()[i]; }
+	T& back() { return data()[size() - 1]; }
+	T* begin() { return data(); }
+	T* end() { return data() + size(); }
+
+	/** Makes room for n elements without reallocating
+	*/
+	void reserve(std::size_t n) {
+		make_private(std::max(n, capacity()));
+	}
+
+	/** Changes the size to n, filling new elements with value
+	*/
+	void resize(std::size_t n, const T& value = T()) {
+		std::size_t old = size();
+		if (n > capacity() || (block && !is_private())) {
+			make_private(n > capacity() ? std::max(n, 2 * capacity()) : capacity());
+		}
+		if (n > old) {
+			std::fill(elements(block) + old, elements(block) + n, value);
+		}
+		if (block) {
+			block->size = n;
+		}
+	}
+
+	/** Removes every element (a shared block is let go of, a private one is kept for reuse)
+	*/
+	void clear() {
+		if (block && !is_private()) {
+			release();
+			block = nullptr;
+		}
+		else if (block) {
+			block->size = 0;
+		}
+	}
+
+	void push_back(const T& value) { resize(size() + 1, value); }
+	void pop_back() { make_private(capacity()); --block->size; }
+
+	/** Replaces the elements with [first, last)
+	*/
+	template <class Iterator>
+	void assign(Iterator first, Iterator last) {
+		clear();
+		std::size_t n = (std::size_t)std::distance(first, last);
+		resize(n);
+		std::copy(first, last, elements(block));
+	}
+
+	/** Inserts count copies of value before position
+		@return the position of the first inserted element
+	*/
+	T* insert(T* position, std::size_t count, const T& value) {
+		std::size_t offset = position - data(), old = size();
+		resize(old + count);
+		T* first = elements(block);
+		std::copy_backward(first + offset, first + old, first + old + count);
+		std::fill(first + offset, first + offset + count, value);
+		return first + offset;
+	}
+
+	/** Removes [first, last)
+		@return the position of the element after the removed ones
+	*/
+	T* erase(T* first, T* last) {
+		T* stop = std::copy(last, end(), first);
+		block->size = stop - elements(block);
+		return first;
+	}
+
+	void swap(CowStorage& other) noexcept { std::swap(block, other.block); } // Exchanges the blocks
+
+	/** Compares the elements
+	*/
+	bool operator==(const CowStorage& other) const {
+		return block == other.block || (size() == other.size() && std::equal(begin(), end(), other.begin()));
+	}
+
+private:
+	struct Block {
+		std::atomic<std::size_t> references;
+		std::size_t size;
+		std::size_t capacity;
+	};
+
+	static const std::size_t header = (sizeof(Block) + sizeof(T) - 1) / sizeof(T); // elements taken by a Block
+
+	static T* elements(Block* b) { return b ? reinterpret_cast<T*>(b) + header : nullptr; }
+
+	bool is_private() const { return block->references.load(std::memory_order_acquire) == 1; }
+	void share() const { // one more copy refers to the block
+		if (block) {
+			block->references.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	/** Drops the reference to the block, freeing it if it was the last one
+	*/
+	void release() {
+		if (block && block->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			std::size_t units = header + block->capacity;
+			block->~Block();
+			Allocator().deallocate(reinterpret_cast<T*>(block), units);
+		}
+	}
+
+	/** Ensures the block is this object's own and holds at least n elements, keeping the elements
+	*/
+	void make_private(std::size_t n) {
+		if (n == 0 || (block && n <= block->capacity && is_private())) { // (n is 0 only without a block)
+			return;
+		}
+		Block* fresh = reinterpret_cast<Block*>(Allocator().allocate(header + n));
+		new (fresh) Block();
+		fresh->references.store(1, std::memory_order_relaxed);
+		fresh->size = size();
+		fresh->capacity = n;
+		if (block) {
+			std::copy(elements(block), elements(block) + block->size, elements(fresh));
+		}
+		release();
+		block = fresh;
+	}
+
+	Block* block; // nullptr when nothing was ever stored
+};
+
+#endif //Ends the include guard
@@ -0,0 +1,305 @@
+/** @file IntegerExpr.h
+	@brief Expression templates for lazy evaluation of compound Integer expressions
+
+	Opt-in: compile with INTEGER_EXPRESSION_TEMPLATES defined and Integer.h includes this file in place of
+	the eager declarations of a + b, a - b and a * b. The natural syntax stays the same:
+		Integer c = -((n - 1)*s(k, n - 1)) + s(k - 1, n - 1);
+	but a + b, a - b and a * b (and -x of such an expression) build a small tree instead of an Integer.
+	The tree is evaluated in one pass when it is converted to an Integer (initialization, assignment,
+	passing by value or returning):
+	1. the result buffer is reserved once, from a bound on the size of the whole tree;
+	2. an expiring operand (e.g. the value returned by s()) is moved into the result instead of copied;
+	3. every product that is added or subtracted is accumulated with addmul() or submul().
+
+	Operands that are lvalues are held by reference, so a tree must be used within the full expression
+	that created it (the same rule as for any expression template). A tree that is compared or printed
+	is converted to an Integer first. Operands of any integral type (int, long, unsigned, std::size_t, ...)
+	are converted exactly, without narrowing to int.
+*/
+
+#ifndef INTEGER_EXPR_H
+#define INTEGER_EXPR_H
+
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+
+class Integer;
+
+namespace integer_expr {
+
+struct Plus {};  // a + b
+struct Minus {}; // a - b
+struct Times {}; // a * b
+
+/** @class Ref
+	@brief Leaf holding an lvalue operand by reference
+*/
+struct Ref {
+	const Integer& value;
+};
+
+/** @class Value
+	@brief Leaf holding an expiring operand (or a converted integral value), which the evaluation may take over
+*/
+struct Value {
+	Integer value;
+};
+
+/** @class Binary
+	@brief Node for lhs Op rhs
+*/
+template <class Op, class L, class R>
+struct Binary {
+	L lhs;
+	R rhs;
+
+	operator Integer() const &; // Evaluates a copy of the tree
+	operator Integer() &&;		// Evaluates the tree, taking over its expiring operands
+};
+
+/** @class Negate
+	@brief Node for -operand
+*/
+template <class E>
+struct Negate {
+	E operand;
+
+	operator Integer() const &; // Evaluates a copy of the tree
+	operator Integer() &&;		// Evaluates the tree, taking over its expiring operands
+};
+
+// Trait: true for tree nodes
+template <class T> struct is_node : std::false_type {};
+template <class Op, class L, class R> struct is_node<Binary<Op, L, R> > : std::true_type {};
+template <class E> struct is_node<Negate<E> > : std::true_type {};
+
+// Trait: true for the integral types that convert exactly to an Integer (int, long, unsigned, std::size_t, ...)
+template <class T>
+struct is_integral_operand : std::integral_constant<bool, std::is_integral<T>::value &&
+	!std::is_same<T, bool>::value && sizeof(T) <= sizeof(Integer::limb)> {};
+
+/** Converts an integral value exactly (Integer(int) alone would narrow a long or an unsigned)
+	@param x value of an integral type
+	@return x as an Integer
+*/
+template <class T, class = typename std::enable_if<is_integral_operand<T>::value>::type>
+Integer integral_value(T x) {
+	typedef typename std::make_unsigned<T>::type Unsigned;
+	bool negative = x < T(); // (T() instead of 0: no warning that an unsigned x is never negative)
+	Integer value = Integer::from_limb(negative ? (Unsigned)(Unsigned() - (Unsigned)x) : (Unsigned)x);
+	return negative ? -std::move(value) : value;
+}
+
+// Wraps an operand into a leaf (or passes a node through)
+inline Ref wrap(const Integer& x) { return Ref{ x }; }
+inline Value wrap(Integer&& x) { return Value{ std::move(x) }; }
+template <class T, class = typename std::enable_if<is_integral_operand<T>::value>::type>
+Value wrap(T x) { return Value{ integral_value(x) }; }
+template <class N, class = typename std::enable_if<is_node<typename std::decay<N>::type>::value>::type>
+typename std::decay<N>::type wrap(N&& node) { return std::forward<N>(node); }
+
+template <class T> using wrapped_t = decltype(wrap(std::declval<T>()));
+
+// Trait: true if T is an Integer or a node (an integral operand alone does not start an expression)
+template <class T>
+struct starts_expr : std::integral_constant<bool,
+	std::is_same<typename std::decay<T>::type, Integer>::value || is_node<typename std::decay<T>::type>::value> {};
+
+template <class T>
+struct is_operand : std::integral_constant<bool,
+	starts_expr<T>::value || is_integral_operand<typename std::decay<T>::type>::value> {};
+
+template <class L, class R>
+using enable_binary_t = typename std::enable_if<is_operand<L>::value && is_operand<R>::value &&
+	(starts_expr<L>::value || starts_expr<R>::value)>::type;
+
+// Comparisons are only taken over when a tree is involved (Integer has its own)
+template <class L, class R>
+using enable_compare_t = typename std::enable_if<is_operand<L>::value && is_operand<R>::value &&
+	(is_node<typename std::decay<L>::type>::value || is_node<typename std::decay<R>::type>::value)>::type;
+
+// Value of an operand of a comparison: trees are evaluated, integral values converted exactly
+inline const Integer& compared(const Integer& x) { return x; }
+template <class T, class = typename std::enable_if<is_integral_operand<T>::value>::type>
+Integer compared(T x) { return integral_value(x); }
+template <class N, class = typename std::enable_if<is_node<typename std::decay<N>::type>::value>::type>
+Integer compared(N&& e) { return Integer(std::forward<N>(e)); }
+
+// Evaluation (found by argument-dependent lookup, so the overloads may refer to each other in any order)
+
+// Bound on the number of limbs of the value of a tree
+inline std::size_t limb_bound(const Ref& r) { return r.value.size(); }
+inline std::size_t limb_bound(const Value& v) { return v.value.size(); }
+template <class L, class R> std::size_t limb_bound(const Binary<Plus, L, R>& e) { return std::max(limb_bound(e.lhs), limb_bound(e.rhs)) + 1; }
+template <class L, class R> std::size_t limb_bound(const Binary<Minus, L, R>& e) { return std::max(limb_bound(e.lhs), limb_bound(e.rhs)) + 1; }
+template <class L, class R> std::size_t limb_bound(const Binary<Times, L, R>& e) { return limb_bound(e.lhs) + limb_bound(e.rhs); }
+template <class E> std::size_t limb_bound(const Negate<E>& e) { return limb_bound(e.operand); }
+
+// Value of an operand of a product: leaves are used as they are, nodes are evaluated (the tree being evaluated
+// owns its nodes, so a nested node is evaluated as an expiring one and its own expiring leaves are taken over)
+inline const Integer& operand(const Ref& r) { return r.value; }
+inline const Integer& operand(const Value& v) { return v.value; }
+template <class E, class = typename std::enable_if<is_node<E>::value>::type>
+Integer operand(E& e) { return Integer(std::move(e)); }
+
+// dest += sign*tree (sign is +1 or -1); dest never aliases an operand of the tree
+inline void accumulate(Integer& dest, const Ref& r, int sign) {
+	if (sign > 0) { dest += r.value; } else { dest -= r.value; }
+}
+inline void accumulate(Integer& dest, const Value& v, int sign) {
+	if (sign > 0) { dest += v.value; } else { dest -= v.value; }
+}
+template <class L, class R> void accumulate(Integer& dest, Binary<Plus, L, R>& e, int sign) {
+	accumulate(dest, e.lhs, sign);
+	accumulate(dest, e.rhs, sign);
+}
+template <class L, class R> void accumulate(Integer& dest, Binary<Minus, L, R>& e, int sign) {
+	accumulate(dest, e.lhs, sign);
+	accumulate(dest, e.rhs, -sign);
+}
+template <class L, class R> void accumulate(Integer& dest, Binary<Times, L, R>& e, int sign) {
+	auto&& x = operand(e.lhs);
+	auto&& y = operand(e.rhs);
+	if (sign > 0) { addmul(dest, x, y); } else { submul(dest, x, y); }
+}
+template <class E> void accumulate(Integer& dest, Negate<E>& e, int sign) {
+	accumulate(dest, e.operand, -sign);
+}
+
+// Moves an expiring leaf that is a direct operand of the node into dest (dest = sign*leaf), then reserves
+// bound limbs, so that the rest of the tree is accumulated without reallocating
+inline bool steal_leaf(Integer& dest, Value& v, int sign, std::size_t bound) {
+	dest = std::move(v.value);
+	if (sign < 0) { dest = -std::move(dest); }
+	dest.reserve(bound);
+	return true;
+}
+template <class E> bool steal_leaf(Integer&, E&, int, std::size_t) { return false; }
+
+// dest = sign*tree, built around an expiring leaf of the tree with bound limbs reserved; returns false if there is none
+template <class E> bool steal(Integer& dest, E& e, int sign, std::size_t bound) { return steal_leaf(dest, e, sign, bound); }
+template <class L, class R> bool steal(Integer& dest, Binary<Plus, L, R>& e, int sign, std::size_t bound) {
+	if (steal_leaf(dest, e.lhs, sign, bound) || steal_leaf(dest, e.rhs, sign, bound)) { // prefer a leaf so products stay fused
+		accumulate(dest, e, sign); // the stolen leaf is now zero and adds nothing
+		return true;
+	}
+	if (steal(dest, e.lhs, sign, bound)) { accumulate(dest, e.rhs, sign); return true; }
+	if (steal(dest, e.rhs, sign, bound)) { accumulate(dest, e.lhs, sign); return true; }
+	return false;
+}
+template <class L, class R> bool steal(Integer& dest, Binary<Minus, L, R>& e, int sign, std::size_t bound) {
+	if (steal_leaf(dest, e.lhs, sign, bound) || steal_leaf(dest, e.rhs, -sign, bound)) {
+		accumulate(dest, e, sign);
+		return true;
+	}
+	if (steal(dest, e.lhs, sign, bound)) { accumulate(dest, e.rhs, -sign); return true; }
+	if (steal(dest, e.rhs, -sign, bound)) { accumulate(dest, e.lhs, sign); return true; }
+	return false;
+}
+template <class L, class R> bool steal(Integer& dest, Binary<Times, L, R>& e, int sign, std::size_t) {
+	// (no reservation: the product is formed in the scratch buffer, which then trades places with dest's limbs)
+	if (steal_leaf(dest, e.lhs, sign, 0)) { dest *= operand(e.rhs); return true; }
+	if (steal_leaf(dest, e.rhs, sign, 0)) { dest *= operand(e.lhs); return true; }
+	return false;
+}
+template <class E> bool steal(Integer& dest, Negate<E>& e, int sign, std::size_t bound) { return steal(dest, e.operand, -sign, bound); }
+
+/** Evaluates a tree in one pass
+	@param e tree (its expiring operands are taken over)
+	@return the value of the tree
+*/
+template <class E> Integer evaluate(E& e) {
+	std::size_t bound = limb_bound(e);
+	Integer dest;
+	if (!steal(dest, e, 1, bound)) {
+		dest.reserve(bound);
+		accumulate(dest, e, 1);
+	}
+	return dest;
+}
+
+template <class Op, class L, class R>
+Binary<Op, L, R>::operator Integer() const & {
+	Binary copy(*this);
+	return evaluate(copy);
+}
+
+template <class Op, class L, class R>
+Binary<Op, L, R>::operator Integer() && {
+	return evaluate(*this);
+}
+
+template <class E>
+Negate<E>::operator Integer() const & {
+	Negate copy(*this);
+	return evaluate(copy);
+}
+
+template <class E>
+Negate<E>::operator Integer() && {
+	return evaluate(*this);
+}
+
+}
+
+/** Builds the tree for a + b
+	@param a Integer, integral value or tree
+	@param b Integer, integral value or tree
+	@return unevaluated a + b
+*/
+template <class L, class R, class = integer_expr::enable_binary_t<L, R> >
+integer_expr::Binary<integer_expr::Plus, integer_expr::wrapped_t<L>, integer_expr::wrapped_t<R> > operator+(L&& a, R&& b) {
+	return { integer_expr::wrap(std::forward<L>(a)), integer_expr::wrap(std::forward<R>(b)) };
+}
+
+/** Builds the tree for a - b
+	@param a Integer, integral value or tree
+	@param b Integer, integral value or tree
+	@return unevaluated a - b
+*/
+template <class L, class R, class = integer_expr::enable_binary_t<L, R> >
+integer_expr::Binary<integer_expr::Minus, integer_expr::wrapped_t<L>, integer_expr::wrapped_t<R> > operator-(L&& a, R&& b) {
+	return { integer_expr::wrap(std::forward<L>(a)), integer_expr::wrap(std::forward<R>(b)) };
+}
+
+/** Builds the tree for a * b
+	@param a Integer, integral value or tree
+	@param b Integer, integral value or tree
+	@return unevaluated a * b
+*/
+template <class L, class R, class = integer_expr::enable_binary_t<L, R> >
+integer_expr::Binary<integer_expr::Times, integer_expr::wrapped_t<L>, integer_expr::wrapped_t<R> > operator*(L&& a, R&& b) {
+	return { integer_expr::wrap(std::forward<L>(a)), integer_expr::wrap(std::forward<R>(b)) };
+}
+
+/** Returns true if a < b, where a or b is a tree
+	@param a Integer, integral value or tree
+	@param b Integer, integral value or tree
+	@return true if a < b
+*/
+template <class L, class R, class = integer_expr::enable_compare_t<L, R> >
+bool operator<(L&& a, R&& b) {
+	return integer_expr::compared(std::forward<L>(a)) < integer_expr::compared(std::forward<R>(b));
+}
+
+/** Returns true if a == b, where a or b is a tree
+	@param a Integer, integral value or tree
+	@param b Integer, integral value or tree
+	@return true if a == b
+*/
+template <class L, class R, class = integer_expr::enable_compare_t<L, R> >
+bool operator==(L&& a, R&& b) {
+	return integer_expr::compared(std::forward<L>(a)) == integer_expr::compared(std::forward<R>(b));
+}
+
+/** Builds the tree for -e (-a of an Integer a is the member operator)
+	@param e tree
+	@return unevaluated -e
+*/
+template <class N, class = typename std::enable_if<integer_expr::is_node<typename std::decay<N>::type>::value>::type>
+integer_expr::Negate<typename std::decay<N>::type> operator-(N&& e) {
+	return { std::forward<N>(e) };
+}
+
+#endif //Ends the include guard
@@ -0,0 +1,97 @@
+/** @file IntegerInternal.h
+	@brief Helpers on magnitudes (limb arrays) shared by Integer.cpp, DecimalInteger.cpp and IntegerTable.cpp
+
+	Not part of the interface: only the implementation files include it.
+	compare_magnitude:	compares two magnitudes without leading zero limbs
+	add_signed:			a = (+/-)a + (+/-)b on magnitudes, in place, in base 2^64 (BinaryLimbs) or any other base
+						whose limb arithmetic is given the same way (DecimalInteger uses base 10^19)
+	product_scratch:	the per-thread buffer that products are formed in before they are added
+*/
+
+#ifndef INTEGER_INTERNAL_H
+#define INTEGER_INTERNAL_H
+
+#include "Integer.h"
+#include "IntegerKernels.h"
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+/** Compares the magnitudes a and b (without leading zero limbs)
+	@return -1 if a < b, 0 if a == b and 1 if a > b
+*/
+inline int compare_magnitude(const Integer::limb* a, std::size_t an, const Integer::limb* b, std::size_t bn) {
+	if (an != bn) {
+		return an < bn ? -1 : 1;
+	}
+	for (std::size_t i = an; i-- > 0; ) { // compares each limb, starting with the most significant
+		if (a[i] != b[i]) {
+			return a[i] < b[i] ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+/** @class BinaryLimbs
+	@brief Limb arithmetic in base 2^64 for add_signed (the limb kernels)
+*/
+struct BinaryLimbs {
+	typedef Integer::limb limb;
+
+	static limb add_n(limb* r, const limb* a, const limb* b, std::size_t n) { return limb_kernels().add_n(r, a, b, n); }
+	static limb sub_n(limb* r, const limb* a, const limb* b, std::size_t n) { return limb_kernels().sub_n(r, a, b, n); }
+	static limb add_1(limb& r, limb a, limb carry) { r = a + carry; return r < carry; }		 // r = a + carry, returns the carry
+	static limb sub_1(limb& r, limb a, limb borrow) { r = a - borrow; return a < borrow; } // r = a - borrow, returns the borrow
+};
+
+/** a = (+/-)a + (+/-)b in place, where a has room for max(an, bn) limbs (those above an being zero) and b does
+	not overlap a; the carry out of the top limb is returned, so that a sum which does not grow needs no more room
+	@param an number of limbs of a (without leading zeros)
+	@param a_negative sign of a, which receives the sign of the result
+	@return the limb above the result (0 or 1); always 0 when the magnitudes are subtracted, in which case the
+	result may have leading zeros
+*/
+template <class Limbs>
+inline Integer::limb add_signed(Integer::limb* a, std::size_t an, bool& a_negative,
+	const Integer::limb* b, std::size_t bn, bool b_negative) {
+	std::size_t n = std::max(an, bn);
+	if (an == 0 || a_negative == b_negative) { // Same sign: add the magnitudes
+		if (an == 0) {
+			a_negative = b_negative;
+		}
+		Integer::limb carry = Limbs::add_n(a, a, b, bn);
+		for (std::size_t i = bn; carry && i < n; ++i) { // propagate the carry
+			carry = Limbs::add_1(a[i], a[i], carry);
+		}
+		return carry;
+	}
+
+	// Different signs: subtract the smaller magnitude from the larger one, which gives the sign
+	int cmp = compare_magnitude(a, an, b, bn);
+	if (cmp == 0) {
+		std::fill(a, a + an, 0);
+		a_negative = false;
+	}
+	else if (cmp > 0) { // |a| > |b|: a keeps its sign
+		Integer::limb borrow = Limbs::sub_n(a, a, b, bn);
+		for (std::size_t i = bn; borrow; ++i) { // propagate the borrow
+			borrow = Limbs::sub_1(a[i], a[i], borrow);
+		}
+	}
+	else { // |a| < |b|: the result takes the sign of b
+		Limbs::sub_n(a, b, a, bn);
+		a_negative = b_negative;
+	}
+	return 0;
+}
+
+/** Per-thread buffer that products are formed in: one for each kind of storage (Integer::storage, or
+	std::vector<limb> for DecimalInteger and IntegerTable, which never hold it across calls to each other)
+*/
+template <class Storage>
+Storage& product_scratch() {
+	thread_local Storage scratch;
+	return scratch;
+}
+
+#endif //Ends the include guard
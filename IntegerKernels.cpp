@@ -0,0 +1,318 @@
+/** @file IntegerKernels.cpp
+	@brief Variants of the limb kernels and their selection (see IntegerKernels.h)
+
+The x86-64 variants are compiled with per-function target attributes, so the whole program can still be
+built for a baseline CPU; a variant is only called after __builtin_cpu_supports has confirmed it can run.
+*/
+
+#include "IntegerKernels.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define INTEGER_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+typedef Integer::limb limb;
+typedef unsigned __int128 dlimb; // Holds the product of two limbs
+
+namespace {
+
+// generic: portable C++
+
+limb add_n_generic(limb* r, const limb* a, const limb* b, std::size_t n) {
+	limb carry = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		limb s = a[i] + carry;
+		carry = (s < carry);
+		s += b[i];
+		carry += (s < b[i]);
+		r[i] = s;
+	}
+	return carry;
+}
+
+limb sub_n_generic(limb* r, const limb* a, const limb* b, std::size_t n) {
+	limb borrow = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		limb bi = b[i] + borrow;
+		borrow = (bi < borrow);
+		borrow += (a[i] < bi);
+		r[i] = a[i] - bi;
+	}
+	return borrow;
+}
+
+limb mul_1_generic(limb* r, const limb* a, std::size_t n, limb b) {
+	limb carry = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		dlimb t = (dlimb)a[i] * b + carry;
+		r[i] = (limb)t;
+		carry = (limb)(t >> 64);
+	}
+	return carry;
+}
+
+limb addmul_1_generic(limb* r, const limb* a, std::size_t n, limb b) {
+	limb carry = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		dlimb t = (dlimb)a[i] * b + r[i] + carry;
+		r[i] = (limb)t;
+		carry = (limb)(t >> 64);
+	}
+	return carry;
+}
+
+limb submul_1_generic(limb* r, const limb* a, std::size_t n, limb b) {
+	limb carry = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		dlimb t = (dlimb)a[i] * b + carry;
+		limb lo = (limb)t;
+		carry = (limb)(t >> 64) + (r[i] < lo);
+		r[i] -= lo;
+	}
+	return carry;
+}
+
+void and_n_generic(limb* r, const limb* a, const limb* b, std::size_t n) {
+	for (std::size_t i = 0; i < n; ++i) {
+		r[i] = a[i] & b[i];
+	}
+}
+
+void or_n_generic(limb* r, const limb* a, const limb* b, std::size_t n) {
+	for (std::size_t i = 0; i < n; ++i) {
+		r[i] = a[i] | b[i];
+	}
+}
+
+void xor_n_generic(limb* r, const limb* a, const limb* b, std::size_t n) {
+	for (std::size_t i = 0; i < n; ++i) {
+		r[i] = a[i] ^ b[i];
+	}
+}
+
+const LimbKernels generic = {
+	"generic",
+	add_n_generic, sub_n_generic, mul_1_generic, addmul_1_generic, submul_1_generic,
+	and_n_generic, or_n_generic, xor_n_generic
+};
+
+#ifdef INTEGER_KERNELS_X86
+
+// adx: mulx for the products, adc/sbb (adcx/adox) for the carry chains. Only addmul_1 needs ADX (its two
+// interleaved chains); the other kernels need at most BMI2, and are shared with the bmi2 variant.
+
+limb add_n_adc(limb* r, const limb* a, const limb* b, std::size_t n) {
+	unsigned char carry = 0;
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) { // unrolled so that the carry stays in the flags
+		carry = _addcarry_u64(carry, a[i], b[i], &r[i]);
+		carry = _addcarry_u64(carry, a[i + 1], b[i + 1], &r[i + 1]);
+		carry = _addcarry_u64(carry, a[i + 2], b[i + 2], &r[i + 2]);
+		carry = _addcarry_u64(carry, a[i + 3], b[i + 3], &r[i + 3]);
+	}
+	for (; i < n; ++i) {
+		carry = _addcarry_u64(carry, a[i], b[i], &r[i]);
+	}
+	return carry;
+}
+
+limb sub_n_adc(limb* r, const limb* a, const limb* b, std::size_t n) {
+	unsigned char borrow = 0;
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		borrow = _subborrow_u64(borrow, a[i], b[i], &r[i]);
+		borrow = _subborrow_u64(borrow, a[i + 1], b[i + 1], &r[i + 1]);
+		borrow = _subborrow_u64(borrow, a[i + 2], b[i + 2], &r[i + 2]);
+		borrow = _subborrow_u64(borrow, a[i + 3], b[i + 3], &r[i + 3]);
+	}
+	for (; i < n; ++i) {
+		borrow = _subborrow_u64(borrow, a[i], b[i], &r[i]);
+	}
+	return borrow;
+}
+
+__attribute__((target("bmi2")))
+limb mul_1_mulx(limb* r, const limb* a, std::size_t n, limb b) {
+	unsigned char carry = 0;
+	limb high = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		limb next_high;
+		limb low = _mulx_u64(a[i], b, &next_high);
+		carry = _addcarry_u64(carry, low, high, &r[i]);
+		high = next_high;
+	}
+	return high + carry;
+}
+
+__attribute__((target("bmi2,adx")))
+limb addmul_1_adx(limb* r, const limb* a, std::size_t n, limb b) {
+	unsigned char carry_high = 0, carry_r = 0; // two independent chains (adcx and adox)
+	limb high = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		limb next_high, sum;
+		limb low = _mulx_u64(a[i], b, &next_high);
+		carry_high = _addcarryx_u64(carry_high, low, high, &sum);
+		carry_r = _addcarryx_u64(carry_r, sum, r[i], &r[i]);
+		high = next_high;
+	}
+	return high + carry_high + carry_r;
+}
+
+__attribute__((target("bmi2")))
+limb submul_1_mulx(limb* r, const limb* a, std::size_t n, limb b) {
+	unsigned char carry_high = 0, borrow = 0;
+	limb high = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		limb next_high, sum;
+		limb low = _mulx_u64(a[i], b, &next_high);
+		carry_high = _addcarry_u64(carry_high, low, high, &sum);
+		borrow = _subborrow_u64(borrow, r[i], sum, &r[i]);
+		high = next_high;
+	}
+	return high + carry_high + borrow;
+}
+
+const LimbKernels adx = {
+	"adx",
+	add_n_adc, sub_n_adc, mul_1_mulx, addmul_1_adx, submul_1_mulx,
+	and_n_generic, or_n_generic, xor_n_generic
+};
+
+// bmi2: mulx without ADX (e.g. Haswell): addmul_1 keeps one carry chain, the high limb and the carry being
+// added before r[i]
+
+__attribute__((target("bmi2")))
+limb addmul_1_mulx(limb* r, const limb* a, std::size_t n, limb b) {
+	limb high = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		limb next_high, sum;
+		limb low = _mulx_u64(a[i], b, &next_high);
+		next_high += _addcarry_u64(0, low, high, &sum); // (a[i]*b + high fits in two limbs)
+		next_high += _addcarry_u64(0, sum, r[i], &r[i]);
+		high = next_high;
+	}
+	return high;
+}
+
+// avx512 and avx2: vector bitwise operations (the remaining limbs are done one at a time)
+
+#define INTEGER_BITWISE_KERNEL(name, isa, vector, load, store, vector_op, op) \
+	__attribute__((target(isa))) \
+	void name(limb* r, const limb* a, const limb* b, std::size_t n) { \
+		const std::size_t width = sizeof(vector) / sizeof(limb); \
+		std::size_t i = 0; \
+		for (; i + width <= n; i += width) { \
+			vector x = load((const vector*)(a + i)); \
+			vector y = load((const vector*)(b + i)); \
+			store((vector*)(r + i), vector_op(x, y)); \
+		} \
+		for (; i < n; ++i) { \
+			r[i] = a[i] op b[i]; \
+		} \
+	}
+
+INTEGER_BITWISE_KERNEL(and_n_avx2, "avx2", __m256i, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_and_si256, &)
+INTEGER_BITWISE_KERNEL(or_n_avx2, "avx2", __m256i, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_or_si256, |)
+INTEGER_BITWISE_KERNEL(xor_n_avx2, "avx2", __m256i, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_xor_si256, ^)
+INTEGER_BITWISE_KERNEL(and_n_avx512, "avx512f", __m512i, _mm512_loadu_si512, _mm512_storeu_si512, _mm512_and_si512, &)
+INTEGER_BITWISE_KERNEL(or_n_avx512, "avx512f", __m512i, _mm512_loadu_si512, _mm512_storeu_si512, _mm512_or_si512, |)
+INTEGER_BITWISE_KERNEL(xor_n_avx512, "avx512f", __m512i, _mm512_loadu_si512, _mm512_storeu_si512, _mm512_xor_si512, ^)
+
+#undef INTEGER_BITWISE_KERNEL
+
+const LimbKernels bmi2 = {
+	"bmi2",
+	add_n_adc, sub_n_adc, mul_1_mulx, addmul_1_mulx, submul_1_mulx,
+	and_n_avx2, or_n_avx2, xor_n_avx2
+};
+
+const LimbKernels avx2 = {
+	"avx2",
+	add_n_adc, sub_n_adc, mul_1_mulx, addmul_1_adx, submul_1_mulx,
+	and_n_avx2, or_n_avx2, xor_n_avx2
+};
+
+const LimbKernels avx512 = {
+	"avx512",
+	add_n_adc, sub_n_adc, mul_1_mulx, addmul_1_adx, submul_1_mulx,
+	and_n_avx512, or_n_avx512, xor_n_avx512
+};
+
+#endif
+
+/** Returns true if this CPU can run the variant
+*/
+bool supported(const LimbKernels& kernels) {
+#ifdef INTEGER_KERNELS_X86
+	__builtin_cpu_init();
+	bool has_bmi2 = __builtin_cpu_supports("bmi2"), has_adx = has_bmi2 && __builtin_cpu_supports("adx");
+	if (&kernels == &adx) {
+		return has_adx;
+	}
+	if (&kernels == &bmi2) {
+		return has_bmi2 && __builtin_cpu_supports("avx2");
+	}
+	if (&kernels == &avx2) {
+		return has_adx && __builtin_cpu_supports("avx2");
+	}
+	if (&kernels == &avx512) {
+		return has_adx && __builtin_cpu_supports("avx512f");
+	}
+#endif
+	return &kernels == &generic;
+}
+
+/** All variants, best first
+*/
+const LimbKernels* const variants[] = {
+#ifdef INTEGER_KERNELS_X86
+	&avx512, &avx2, &adx, &bmi2,
+#endif
+	&generic
+};
+
+/** Picks the variant: INTEGER_KERNELS if it is set and supported, otherwise the best supported one
+*/
+const LimbKernels& select_kernels() {
+	const char* forced = std::getenv("INTEGER_KERNELS");
+	if (forced != nullptr && *forced != '\0') {
+		const LimbKernels* kernels = find_limb_kernels(forced);
+		if (kernels != nullptr) {
+			return *kernels;
+		}
+		std::cerr << "INTEGER_KERNELS=" << forced << " is unknown or not supported by this CPU; ignored" << std::endl;
+	}
+	for (const LimbKernels* kernels : variants) {
+		if (supported(*kernels)) {
+			return *kernels;
+		}
+	}
+	return generic;
+}
+
+}
+
+/** Returns the kernels selected for this CPU (chosen once, on first use)
+	@return kernel table
+*/
+const LimbKernels& limb_kernels() {
+	static const LimbKernels& selected = select_kernels();
+	return selected;
+}
+
+/** Looks up a variant by name
+	@param name e.g. "generic" or "adx"
+	@return the variant, or nullptr if it is unknown or this CPU cannot run it
+*/
+const LimbKernels* find_limb_kernels(const char* name) {
+	for (const LimbKernels* kernels : variants) {
+		if (std::strcmp(kernels->name, name) == 0) {
+			return supported(*kernels) ? kernels : nullptr;
+		}
+	}
+	return nullptr;
+}
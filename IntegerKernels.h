@@ -0,0 +1,47 @@
+/** @file IntegerKernels.h
+	@brief Limb kernels used by Integer, with variants selected at run time from the CPU
+
+	Each kernel works on little-endian arrays of n limbs:
+	add_n:		r = a + b, returns the carry			sub_n:		r = a - b, returns the borrow
+	mul_1:		r = a*b, returns the high limb		addmul_1:	r += a*b, returns the high limb
+	submul_1:	r -= a*b, returns the high limb		and_n, or_n, xor_n:	r = a op b
+	The output r may be the same array as a (and as b for add_n, sub_n and the bitwise kernels).
+
+	Variants, best first (the first one that the CPU supports is used):
+	avx512:	mulx/adcx/adox carry chains, AVX-512 bitwise operations
+	avx2:	mulx/adcx/adox carry chains, AVX2 bitwise operations
+	adx:	mulx/adcx/adox carry chains, portable bitwise operations (which the compiler vectorizes for SSE2)
+	bmi2:	mulx with adc/sbb carry chains, AVX2 bitwise operations (CPUs with BMI2 but without ADX, e.g. Haswell)
+	generic: portable C++
+	The choice is made once, on first use. Setting the environment variable INTEGER_KERNELS to one of the names
+	above forces that variant (e.g. for benchmarking); a variant the CPU cannot run is ignored with a warning.
+*/
+
+#ifndef INTEGER_KERNELS_H
+#define INTEGER_KERNELS_H
+
+#include "Integer.h"
+#include <cstddef>
+
+/** @class LimbKernels
+	@brief One variant of the limb kernels
+*/
+struct LimbKernels {
+	typedef Integer::limb limb;
+
+	const char* name; // variant name, as accepted by INTEGER_KERNELS
+
+	limb (*add_n)(limb* r, const limb* a, const limb* b, std::size_t n);
+	limb (*sub_n)(limb* r, const limb* a, const limb* b, std::size_t n);
+	limb (*mul_1)(limb* r, const limb* a, std::size_t n, limb b);
+	limb (*addmul_1)(limb* r, const limb* a, std::size_t n, limb b);
+	limb (*submul_1)(limb* r, const limb* a, std::size_t n, limb b);
+	void (*and_n)(limb* r, const limb* a, const limb* b, std::size_t n);
+	void (*or_n)(limb* r, const limb* a, const limb* b, std::size_t n);
+	void (*xor_n)(limb* r, const limb* a, const limb* b, std::size_t n);
+};
+
+const LimbKernels& limb_kernels(); // The variant selected for this CPU (or by INTEGER_KERNELS)
+const LimbKernels* find_limb_kernels(const char* name); // The named variant, or nullptr if this CPU cannot run it
+
+#endif //Ends the include guard
@@ -0,0 +1,231 @@
+/** @file IntegerNTT.cpp
+	@brief Multiplication by number theoretic transforms modulo three primes (see IntegerNTT.h)
+
+The forward transform is decimation in frequency: it takes the coefficients in their natural order and leaves
+the transform in bit-reversed order. The inverse transform is decimation in time, which takes the bit-reversed
+order back to the natural one, so no permutation is ever done. All values are kept in [0, q) in Montgomery form
+(x R mod q, with R = 2^64).
+*/
+
+#include "IntegerNTT.h"
+#include <vector>
+
+typedef Integer::limb limb;
+typedef unsigned __int128 dlimb; // Holds the product of two limbs
+
+namespace {
+
+/** @class Modulus
+	@brief Montgomery arithmetic modulo a prime q < 2^63
+*/
+class Modulus {
+public:
+	/** Constructor of Modulus
+		@param q odd prime below 2^63
+	*/
+	explicit Modulus(limb q) : q(q) {
+		inverse = q; // q^2 = 1 (mod 8); each Newton step doubles the number of correct bits
+		for (int i = 0; i < 5; ++i) {
+			inverse *= 2 - q * inverse;
+		}
+		limb r = (limb)(((dlimb)1 << 64) % q);
+		r2 = (limb)((dlimb)r * r % q);
+	}
+
+	/** Returns t R^-1 mod q for t < q 2^64
+	*/
+	limb reduce(dlimb t) const {
+		limb m = (limb)t * -inverse; // t + m q = 0 (mod 2^64)
+		limb u = (limb)((t + (dlimb)m * q) >> 64); // below 2q, as t + m q < q 2^65
+		return u >= q ? u - q : u;
+	}
+
+	limb to_montgomery(limb a) const { return reduce((dlimb)a * r2); } // a R mod q (any a)
+	limb multiply(limb a, limb b) const { return reduce((dlimb)a * b); } // a b R^-1 mod q
+	limb add(limb a, limb b) const { limb s = a + b; return s >= q ? s - q : s; }
+	limb subtract(limb a, limb b) const { return a >= b ? a - b : a + q - b; }
+
+	/** Returns a^e in Montgomery form
+		@param a in Montgomery form
+	*/
+	limb power(limb a, limb e) const {
+		limb result = to_montgomery(1);
+		for (; e != 0; e >>= 1) {
+			if (e & 1) {
+				result = multiply(result, a);
+			}
+			a = multiply(a, a);
+		}
+		return result;
+	}
+
+	limb q;
+private:
+	limb inverse; // q^-1 mod 2^64
+	limb r2;	  // R^2 mod q
+};
+
+/** @class Prime
+	@brief A prime q = c 2^k + 1 for the transforms, with a generator of its multiplicative group
+*/
+struct Prime {
+	limb q;
+	limb generator;
+};
+
+// In increasing order (Garner's method below relies on it)
+const Prime primes[3] = {
+	{ 2053641430080946177ULL, 7 }, // 57 * 2^55 + 1
+	{ 4179340454199820289ULL, 3 }, // 29 * 2^57 + 1
+	{ 6269010681299730433ULL, 5 }  // 87 * 2^56 + 1
+};
+
+/** Fills the twiddle factors of every level: twiddles[h + j] = w^j for 0 <= j < h, where w is a root of unity of
+	order 2h (in Montgomery form), for h = 1, 2, 4, ..., n/2
+	@param root root of unity of order n
+*/
+void twiddles(const Modulus& m, limb root, std::size_t n, std::vector<limb>& twiddles) {
+	twiddles.assign(n, 0);
+	for (std::size_t h = n / 2; h >= 1; h /= 2) {
+		limb w = m.to_montgomery(1);
+		for (std::size_t j = 0; j < h; ++j) {
+			twiddles[h + j] = w;
+			w = m.multiply(w, root);
+		}
+		root = m.multiply(root, root);
+	}
+}
+
+/** Forward transform (decimation in frequency): natural order in, bit-reversed order out
+*/
+void forward(const Modulus& m, limb* a, std::size_t n, const std::vector<limb>& twiddles) {
+	for (std::size_t h = n / 2; h >= 1; h /= 2) {
+		const limb* w = &twiddles[h];
+		for (std::size_t start = 0; start < n; start += 2 * h) {
+			limb* x = a + start;
+			limb* y = x + h;
+			for (std::size_t j = 0; j < h; ++j) {
+				limb u = x[j], v = y[j];
+				x[j] = m.add(u, v);
+				y[j] = m.multiply(m.subtract(u, v), w[j]);
+			}
+		}
+	}
+}
+
+/** Inverse transform without the division by n (decimation in time): bit-reversed order in, natural order out
+	@param twiddles twiddle factors of the inverse root
+*/
+void inverse(const Modulus& m, limb* a, std::size_t n, const std::vector<limb>& twiddles) {
+	for (std::size_t h = 1; h < n; h *= 2) {
+		const limb* w = &twiddles[h];
+		for (std::size_t start = 0; start < n; start += 2 * h) {
+			limb* x = a + start;
+			limb* y = x + h;
+			for (std::size_t j = 0; j < h; ++j) {
+				limb u = x[j], v = m.multiply(y[j], w[j]);
+				x[j] = m.add(u, v);
+				y[j] = m.subtract(u, v);
+			}
+		}
+	}
+}
+
+/** Computes the cyclic convolution of a and b modulo one prime
+	@param residues receives the n coefficients of the convolution (plain residues, not in Montgomery form)
+*/
+void convolution(const Prime& prime, const limb* a, std::size_t an, const limb* b, std::size_t bn, std::size_t n,
+	std::vector<limb>& residues, std::vector<limb>& work) {
+	const Modulus m(prime.q);
+	std::size_t log_n = 0;
+	while (((std::size_t)1 << log_n) < n) {
+		++log_n;
+	}
+	limb root = m.power(m.to_montgomery(prime.generator), (prime.q - 1) >> log_n); // of order n
+	std::vector<limb> table;
+	twiddles(m, root, n, table);
+
+	residues.assign(n, 0);
+	for (std::size_t i = 0; i < an; ++i) {
+		residues[i] = m.to_montgomery(a[i]);
+	}
+	forward(m, residues.data(), n, table);
+	if (a == b && an == bn) { // a square
+		for (std::size_t i = 0; i < n; ++i) {
+			residues[i] = m.multiply(residues[i], residues[i]);
+		}
+	}
+	else {
+		work.assign(n, 0);
+		for (std::size_t i = 0; i < bn; ++i) {
+			work[i] = m.to_montgomery(b[i]);
+		}
+		forward(m, work.data(), n, table);
+		for (std::size_t i = 0; i < n; ++i) {
+			residues[i] = m.multiply(residues[i], work[i]);
+		}
+	}
+
+	twiddles(m, m.power(root, n - 1), n, table); // root^-1
+	inverse(m, residues.data(), n, table);
+	limb scale = m.reduce(m.power(m.to_montgomery((limb)n), prime.q - 2)); // plain n^-1: the products leave Montgomery form
+	for (std::size_t i = 0; i < n; ++i) {
+		residues[i] = m.multiply(residues[i], scale);
+	}
+}
+
+/** Returns a^-1 mod q (q prime)
+*/
+limb inverse_mod(limb a, limb q) {
+	const Modulus m(q);
+	return m.reduce(m.power(m.to_montgomery(a), q - 2)); // plain value
+}
+
+}
+
+/** Multiplies limb arrays with transforms modulo three primes (see IntegerNTT.h)
+	@param r receives a*b (an + bn limbs); must not overlap a or b
+	@param a first factor (an limbs)
+	@param b second factor (bn limbs; may be a itself for a square)
+*/
+void ntt_multiply(limb* r, const limb* a, std::size_t an, const limb* b, std::size_t bn) {
+	std::size_t n = 1;
+	while (n < an + bn) {
+		n *= 2;
+	}
+	std::vector<limb> residues[3], work;
+	for (int i = 0; i < 3; ++i) {
+		convolution(primes[i], a, an, b, bn, n, residues[i], work);
+	}
+
+	// Garner: x = v1 + q1 v2 + q1 q2 v3 with v1 = x mod q1, v2 = (x - v1)/q1 mod q2, v3 = (x - v1 - q1 v2)/(q1 q2) mod q3
+	const limb q1 = primes[0].q, q2 = primes[1].q, q3 = primes[2].q;
+	const Modulus m2(q2), m3(q3);
+	const limb q1_inverse_2 = m2.to_montgomery(inverse_mod(q1 % q2, q2)); // multiplying by it leaves plain values
+	const limb q1_inverse_3 = m3.to_montgomery(inverse_mod(q1 % q3, q3));
+	const limb q2_inverse_3 = m3.to_montgomery(inverse_mod(q2 % q3, q3));
+	const dlimb q12 = (dlimb)q1 * q2;
+	const limb q12_low = (limb)q12, q12_high = (limb)(q12 >> 64);
+
+	limb carry0 = 0, carry1 = 0, carry2 = 0; // running sum, 192 bits
+	for (std::size_t i = 0; i < an + bn; ++i) {
+		limb v1 = residues[0][i];
+		limb v2 = m2.multiply(m2.subtract(residues[1][i], v1), q1_inverse_2);
+		limb v3 = m3.multiply(m3.subtract(m3.multiply(m3.subtract(residues[2][i], v1), q1_inverse_3), v2), q2_inverse_3);
+
+		// x = v1 + q1 v2 + q12 v3, added to the carry
+		dlimb t = (dlimb)q1 * v2 + v1;
+		dlimb low = (dlimb)q12_low * v3;
+		dlimb high = (dlimb)q12_high * v3 + (limb)(low >> 64);
+		dlimb s = (dlimb)carry0 + (limb)t + (limb)low;
+		limb x0 = (limb)s;
+		s = (s >> 64) + carry1 + (limb)(t >> 64) + (limb)high;
+		limb x1 = (limb)s;
+		limb x2 = (limb)(s >> 64) + carry2 + (limb)(high >> 64);
+
+		r[i] = x0;
+		carry0 = x1;
+		carry1 = x2;
+		carry2 = 0;
+	}
+}
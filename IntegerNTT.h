@@ -0,0 +1,22 @@
+/** @file IntegerNTT.h
+	@brief Multiplication of long limb arrays by number theoretic transforms, for the largest Integer products
+
+	Each limb is one coefficient of a polynomial in 2^64, so a product of limb arrays is a convolution of their
+	limbs followed by carrying. The convolution is computed modulo three primes q = c 2^k + 1 just below 2^63
+	(each with a root of unity of order 2^55) by forward transforms, pointwise products and an inverse transform,
+	in Montgomery arithmetic. Every coefficient of the convolution is below 2^128 times the length, which is less
+	than the product of the primes (2^185), so it is reconstructed exactly from its three residues (Garner's
+	method) and added into the result with a running carry. The cost is O(n log n) for n limbs, against
+	O(n^1.58) for Karatsuba's method; Integer switches over at ntt_threshold() limbs (see Integer.h).
+*/
+
+#ifndef INTEGER_NTT_H
+#define INTEGER_NTT_H
+
+#include "Integer.h"
+#include <cstddef>
+
+// r = a * b over an + bn limbs, where r does not overlap a or b (a and b may be the same array)
+void ntt_multiply(Integer::limb* r, const Integer::limb* a, std::size_t an, const Integer::limb* b, std::size_t bn);
+
+#endif //Ends the include guard
@@ -0,0 +1,308 @@
+/** @file IntegerStats.cpp
+	@brief Per-thread counters of the Integer instrumentation and their report (see IntegerStats.h)
+
+Each thread writes only its own counters (relaxed atomic loads and stores, no read-modify-write), and
+registers them in a list so that integer_stats can read every thread. When a thread exits, its counters are
+added to a total kept for the exited threads.
+*/
+
+#include "IntegerStats.h"
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* const op_names[integer_op_count] = {
+	"add", "sub", "mul", "addmul", "submul", "addmul_limb", "submul_limb", "divide_limb",
+	"mul_limb", "compare", "shift", "bitwise", "clean_up", "print", "parse"
+};
+
+#ifdef INTEGER_STATS
+
+/** Adds the counters of b to a
+*/
+void accumulate(IntegerStats& a, const IntegerStats& b) {
+	for (std::size_t op = 0; op < integer_op_count; ++op) {
+		a.operations[op].calls += b.operations[op].calls;
+		a.operations[op].nanoseconds += b.operations[op].nanoseconds;
+		for (std::size_t bucket = 0; bucket < integer_size_buckets; ++bucket) {
+			a.operations[op].sizes[bucket] += b.operations[op].sizes[bucket];
+		}
+	}
+	a.allocations += b.allocations;
+	a.deallocations += b.deallocations;
+	a.allocated_bytes += b.allocated_bytes;
+}
+
+/** @class Counter
+	@brief Counter written by one thread and read by any: relaxed loads and stores, no locked instructions
+*/
+struct Counter {
+	std::atomic<std::uint64_t> value{0};
+
+	void add(std::uint64_t amount) {
+		value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+	}
+	std::uint64_t get() const {
+		return value.load(std::memory_order_relaxed);
+	}
+};
+
+/** @class ThreadCounters
+	@brief The counters of one thread
+*/
+struct ThreadCounters {
+	struct Operation {
+		Counter calls;
+		Counter nanoseconds;
+		Counter sizes[integer_size_buckets];
+	};
+	Operation operations[integer_op_count];
+	Counter allocations;
+	Counter deallocations;
+	Counter allocated_bytes;
+
+	ThreadCounters();
+	~ThreadCounters();
+
+	/** Returns the current values
+	*/
+	IntegerStats read() const {
+		IntegerStats stats = IntegerStats();
+		for (std::size_t op = 0; op < integer_op_count; ++op) {
+			stats.operations[op].calls = operations[op].calls.get();
+			stats.operations[op].nanoseconds = operations[op].nanoseconds.get();
+			for (std::size_t bucket = 0; bucket < integer_size_buckets; ++bucket) {
+				stats.operations[op].sizes[bucket] = operations[op].sizes[bucket].get();
+			}
+		}
+		stats.allocations = allocations.get();
+		stats.deallocations = deallocations.get();
+		stats.allocated_bytes = allocated_bytes.get();
+		return stats;
+	}
+};
+
+/** @class Registry
+	@brief The counters of the running threads, and the total of the exited ones
+*/
+struct Registry {
+	std::mutex lock;
+	std::vector<ThreadCounters*> threads;
+	IntegerStats exited = IntegerStats();
+};
+
+/** Returns the registry (never destroyed, so that threads exiting after main can still use it)
+*/
+Registry& registry() {
+	static Registry* instance = new Registry;
+	return *instance;
+}
+
+ThreadCounters::ThreadCounters() {
+	Registry& r = registry();
+	std::lock_guard<std::mutex> guard(r.lock);
+	r.threads.push_back(this);
+}
+
+thread_local bool counters_destroyed = false; // set once this thread's counters are gone (at its exit)
+
+ThreadCounters::~ThreadCounters() {
+	counters_destroyed = true;
+	Registry& r = registry();
+	std::lock_guard<std::mutex> guard(r.lock);
+	accumulate(r.exited, read());
+	for (std::size_t i = 0; i < r.threads.size(); ++i) {
+		if (r.threads[i] == this) {
+			r.threads.erase(r.threads.begin() + i);
+			break;
+		}
+	}
+}
+
+/** Returns the counters of this thread, or nullptr while it exits (storage freed after them is not counted)
+*/
+ThreadCounters* thread_counters() {
+	if (counters_destroyed) {
+		return nullptr;
+	}
+	thread_local ThreadCounters counters;
+	return &counters;
+}
+
+/** Returns the bucket of a size: the number of bits of limbs
+*/
+std::size_t size_bucket(std::size_t limbs) {
+	std::size_t bucket = 0;
+	while (limbs != 0) {
+		++bucket;
+		limbs >>= 1;
+	}
+	return bucket;
+}
+
+#endif
+
+/** Writes the report at exit if INTEGER_STATS was set in the environment
+*/
+struct ExitReport {
+	std::string destination; // "" (no report), "1" (standard error) or a file name
+
+	ExitReport() {
+		const char* setting = std::getenv("INTEGER_STATS");
+		if (setting != nullptr && *setting != '\0' && std::string(setting) != "0") {
+			destination = setting;
+			integer_stats_enable(true);
+		}
+	}
+	~ExitReport() {
+		if (destination.empty()) {
+			return;
+		}
+		if (destination == "1") {
+			integer_stats_report(std::cerr);
+		}
+		else {
+			std::ofstream out(destination);
+			integer_stats_report(out);
+		}
+	}
+} exit_report;
+
+}
+
+#ifdef INTEGER_STATS
+
+std::atomic<bool> integer_stats_on(false);
+
+/** Counts one call of op
+	@param op operation
+	@param limbs size of its largest operand
+	@param nanoseconds time spent in it
+*/
+void integer_stats_record(IntegerOp op, std::size_t limbs, std::uint64_t nanoseconds) {
+	ThreadCounters* counters = thread_counters();
+	if (counters != nullptr) {
+		ThreadCounters::Operation& operation = counters->operations[(std::size_t)op];
+		operation.calls.add(1);
+		operation.nanoseconds.add(nanoseconds);
+		operation.sizes[size_bucket(limbs)].add(1);
+	}
+}
+
+/** Counts one allocation of limb storage
+	@param bytes size of the allocation
+*/
+void integer_stats_allocation(std::size_t bytes) {
+	ThreadCounters* counters = thread_counters();
+	if (counters != nullptr) {
+		counters->allocations.add(1);
+		counters->allocated_bytes.add(bytes);
+	}
+}
+
+/** Counts one free of limb storage
+	@param bytes size of the allocation being freed
+*/
+void integer_stats_deallocation(std::size_t) {
+	ThreadCounters* counters = thread_counters();
+	if (counters != nullptr) {
+		counters->deallocations.add(1);
+	}
+}
+
+#endif
+
+/** Returns the name of an operation
+	@param op operation
+	@return e.g. "addmul_limb"
+*/
+const char* integer_op_name(IntegerOp op) {
+	return op_names[(std::size_t)op];
+}
+
+/** Starts or stops recording (has no effect unless INTEGER_STATS is defined)
+	@param on true to record
+*/
+void integer_stats_enable(bool on) {
+#ifdef INTEGER_STATS
+	integer_stats_on.store(on, std::memory_order_relaxed);
+#else
+	(void)on;
+#endif
+}
+
+/** Adds up the counters of all threads, running or exited (the running threads are read while they count)
+	@return counters
+*/
+IntegerStats integer_stats() {
+	IntegerStats stats = IntegerStats();
+#ifdef INTEGER_STATS
+	Registry& r = registry();
+	std::lock_guard<std::mutex> guard(r.lock);
+	stats = r.exited;
+	for (const ThreadCounters* counters : r.threads) {
+		accumulate(stats, counters->read());
+	}
+#endif
+	return stats;
+}
+
+/** Sets all counters to zero (best done while no other thread is using Integer)
+*/
+void integer_stats_reset() {
+#ifdef INTEGER_STATS
+	Registry& r = registry();
+	std::lock_guard<std::mutex> guard(r.lock);
+	r.exited = IntegerStats();
+	for (ThreadCounters* counters : r.threads) {
+		for (ThreadCounters::Operation& operation : counters->operations) {
+			operation.calls.value.store(0, std::memory_order_relaxed);
+			operation.nanoseconds.value.store(0, std::memory_order_relaxed);
+			for (Counter& size : operation.sizes) {
+				size.value.store(0, std::memory_order_relaxed);
+			}
+		}
+		counters->allocations.value.store(0, std::memory_order_relaxed);
+		counters->deallocations.value.store(0, std::memory_order_relaxed);
+		counters->allocated_bytes.value.store(0, std::memory_order_relaxed);
+	}
+#endif
+}
+
+/** Writes the counters as a table: one line per operation that was called, then the allocations
+	@param out destination (e.g. std::cerr)
+*/
+void integer_stats_report(std::ostream& out) {
+#ifndef INTEGER_STATS
+	out << "Integer statistics are not compiled in (define INTEGER_STATS)\n";
+#else
+	IntegerStats stats = integer_stats();
+	out << "Integer statistics\n";
+	out << std::left << std::setw(13) << "operation" << std::right << std::setw(14) << "calls" << std::setw(14) << "total ms"
+		<< std::setw(12) << "mean ns" << "  operand limbs (log2 bucket: calls)\n";
+	for (std::size_t op = 0; op < integer_op_count; ++op) {
+		const IntegerStats::Operation& operation = stats.operations[op];
+		if (operation.calls == 0) {
+			continue;
+		}
+		out << std::left << std::setw(13) << op_names[op] << std::right << std::setw(14) << operation.calls
+			<< std::setw(14) << std::fixed << std::setprecision(3) << operation.nanoseconds / 1e6
+			<< std::setw(12) << std::setprecision(1) << (double)operation.nanoseconds / operation.calls << " ";
+		out.unsetf(std::ios::fixed);
+		for (std::size_t bucket = 0; bucket < integer_size_buckets; ++bucket) {
+			if (operation.sizes[bucket] != 0) { // bucket b holds 2^(b-1) .. 2^b - 1 limbs
+				out << " " << (bucket == 0 ? 0 : (std::size_t)1 << (bucket - 1)) << "+:" << operation.sizes[bucket];
+			}
+		}
+		out << "\n";
+	}
+	out << "allocations: " << stats.allocations << " (" << stats.allocated_bytes << " bytes), frees: "
+		<< stats.deallocations << "\n";
+#endif
+}
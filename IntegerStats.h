@@ -0,0 +1,164 @@
+/** @file IntegerStats.h
+	@brief Optional instrumentation of Integer: operation counts and times, operand sizes, heap allocations
+
+	The instrumentation is compiled in only when INTEGER_STATS is defined (for the whole program: it changes
+	the allocator of Integer, e.g. cmake -DINTEGER_STATS=ON). Without it, INTEGER_STATS_SCOPE expands to nothing
+	and Integer uses std::allocator, so there is no cost at all.
+
+	When it is compiled in, recording is switched on at run time, either by the environment variable
+	INTEGER_STATS (1: report to standard error at exit; any other value: the file to write the report to at exit)
+	or by integer_stats_enable. While it is off, each operation only checks one flag.
+
+	For each operation, the counters hold:
+	calls:			number of calls
+	nanoseconds:	total time in the operation (inclusive: a + b also counts its +=)
+	sizes[b]:		calls whose largest operand has between 2^(b-1) and 2^b - 1 limbs (sizes[0]: zero)
+	and for the whole program the number of heap allocations, frees and allocated bytes of limb storage.
+	The counters are per thread; integer_stats adds up the threads (including those that have exited).
+*/
+
+#ifndef INTEGER_STATS_H
+#define INTEGER_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+
+/** @enum IntegerOp
+	@brief The operations that are counted
+*/
+enum class IntegerOp {
+	add,		 // +=
+	sub,		 // -=
+	mul,		 // *=
+	addmul,		 // addmul
+	submul,		 // submul
+	addmul_limb, // addmul_limb
+	submul_limb, // submul_limb
+	divide_limb, // divide_limb
+	mul_limb,	 // mul_limb
+	compare,	 // <, ==
+	shift,		 // <<=, >>=
+	bitwise,	 // &=, |=, ^=, ~
+	clean_up,	 // clean_up
+	print,		 // print_as_int, print_as_bits
+	parse,		 // >>
+	count		 // number of operations (not an operation)
+};
+
+const std::size_t integer_op_count = (std::size_t)IntegerOp::count;
+const std::size_t integer_size_buckets = 65; // log2 buckets of the operand size in limbs
+
+/** @class IntegerStats
+	@brief Counters added up over all threads (see the file description)
+*/
+struct IntegerStats {
+	struct Operation {
+		std::uint64_t calls;
+		std::uint64_t nanoseconds;
+		std::uint64_t sizes[integer_size_buckets];
+	};
+	Operation operations[integer_op_count];
+	std::uint64_t allocations;
+	std::uint64_t deallocations;
+	std::uint64_t allocated_bytes;
+};
+
+const char* integer_op_name(IntegerOp op);			// e.g. "addmul_limb"
+void integer_stats_enable(bool on);					// Starts or stops recording
+IntegerStats integer_stats();						// Adds up the counters of all threads
+void integer_stats_reset();							// Sets all counters to zero
+void integer_stats_report(std::ostream& out);		// Writes integer_stats() as a table
+
+#ifdef INTEGER_STATS
+
+extern std::atomic<bool> integer_stats_on; // recording switch
+
+/** Returns true while recording is switched on
+*/
+inline bool integer_stats_enabled() {
+	return integer_stats_on.load(std::memory_order_relaxed);
+}
+
+void integer_stats_record(IntegerOp op, std::size_t limbs, std::uint64_t nanoseconds); // Counts one call
+void integer_stats_allocation(std::size_t bytes);	// Counts one allocation
+void integer_stats_deallocation(std::size_t bytes); // Counts one free
+
+/** @class IntegerStatsScope
+	@brief Times one call of an operation (from construction to destruction)
+*/
+class IntegerStatsScope {
+public:
+	IntegerStatsScope(IntegerOp op, std::size_t limbs) : op(op), limbs(limbs), active(integer_stats_enabled()) {
+		if (active) {
+			start = std::chrono::steady_clock::now();
+		}
+	}
+	~IntegerStatsScope() {
+		if (active) {
+			std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+			integer_stats_record(op, limbs, (std::uint64_t)elapsed.count());
+		}
+	}
+	IntegerStatsScope(const IntegerStatsScope&) = delete;
+	IntegerStatsScope& operator=(const IntegerStatsScope&) = delete;
+
+private:
+	IntegerOp op;
+	std::size_t limbs;
+	bool active;
+	std::chrono::steady_clock::time_point start;
+};
+
+/** @class IntegerAllocator
+	@brief std::allocator that counts the allocations and bytes of limb storage
+*/
+template <class T>
+struct IntegerAllocator {
+	typedef T value_type;
+
+	IntegerAllocator() = default;
+	template <class U>
+	IntegerAllocator(const IntegerAllocator<U>&) {
+	}
+
+	T* allocate(std::size_t n) {
+		if (integer_stats_enabled()) {
+			integer_stats_allocation(n * sizeof(T));
+		}
+		return std::allocator<T>().allocate(n);
+	}
+	void deallocate(T* p, std::size_t n) {
+		if (integer_stats_enabled()) {
+			integer_stats_deallocation(n * sizeof(T));
+		}
+		std::allocator<T>().deallocate(p, n);
+	}
+};
+
+template <class T, class U>
+bool operator==(const IntegerAllocator<T>&, const IntegerAllocator<U>&) {
+	return true;
+}
+
+template <class T, class U>
+bool operator!=(const IntegerAllocator<T>&, const IntegerAllocator<U>&) {
+	return false;
+}
+
+// Times the rest of the enclosing block as one call of op, whose largest operand has limbs limbs
+#define INTEGER_STATS_SCOPE(op, limbs) IntegerStatsScope integer_stats_scope(IntegerOp::op, (limbs))
+
+#else
+
+template <class T>
+using IntegerAllocator = std::allocator<T>;
+
+#define INTEGER_STATS_SCOPE(op, limbs) ((void)0)
+
+#endif
+
+#endif //Ends the include guard
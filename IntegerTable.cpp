@@ -0,0 +1,325 @@
+/** @file IntegerTable.cpp
+	@brief Packed storage of many Integers in one limb pool (see IntegerTable.h)
+
+A new cell is computed directly at the end of the pool: the pool is first extended by enough limbs for the
+largest possible result, the limb kernels write the result there, and the pool is then cut back to the
+actual length. Extending the pool may move it; operands that are cells of the same table are re-pointed to
+the new pool before the result is computed.
+*/
+
+#include "IntegerTable.h"
+#include "IntegerInternal.h"
+#include "IntegerKernels.h"
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <ostream>
+#include <utility>
+
+typedef IntegerTable::limb limb;
+
+/** Default constructor of IntegerView: views zero
+*/
+IntegerView::IntegerView() : data(nullptr), length(0), sign(0) {
+}
+
+/** Constructor of IntegerView from an array of limbs
+	@param limbs magnitude, least significant limb first
+	@param size number of limbs (the top limb must not be zero)
+	@param negative true for a negative value (must be false for zero)
+*/
+IntegerView::IntegerView(const limb* limbs, std::size_t size, bool negative) : data(limbs), length(size), sign(negative) {
+}
+
+/** Constructor of IntegerView from an Integer
+	@param value the Integer being viewed (the view is valid while value is unchanged)
+*/
+IntegerView::IntegerView(const Integer& value) : data(value.limbs()), length(value.size()), sign(value.negative()) {
+}
+
+/** Returns the magnitude
+	@return the size() limbs, least significant first
+*/
+const limb* IntegerView::limbs() const {
+	return data;
+}
+
+/** Returns the number of limbs in the magnitude
+	@return number of limbs (0 for zero)
+*/
+std::size_t IntegerView::size() const {
+	return length;
+}
+
+/** Returns true if the value is negative
+	@return true if the value < 0
+*/
+bool IntegerView::negative() const {
+	return sign;
+}
+
+/** Copies the value into an Integer
+	@return the same value as an Integer
+*/
+Integer IntegerView::to_integer() const {
+	return Integer::from_limbs(data, length, sign);
+}
+
+/** Prints the value in base 10
+	@param out specifies the type of output: cout or outputData
+*/
+void IntegerView::print_as_int(std::ostream& out) const {
+	Integer::print_as_int(out, data, length, sign);
+}
+
+/** Output operator <<
+	@param out allows std::cout, etc output types
+	@param value the view being printed
+	@return out so that << can be called consecutively
+*/
+std::ostream& operator<<(std::ostream& out, const IntegerView& value) {
+	value.print_as_int(out);
+	return out;
+}
+
+/** Writes value in binary, in the same format as write_binary(Integer), so that read_binary(Integer) reads it
+	@param out destination (opened in binary mode)
+	@param value the value to write
+*/
+void write_binary(std::ostream& out, const IntegerView& value) {
+	limb header = (limb)value.size() * 2 + value.negative();
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(value.limbs()), (std::streamsize)(value.size() * sizeof(limb)));
+}
+
+/** Compares a and b
+	@return -1 if a < b, 0 if a == b and 1 if a > b
+*/
+int compare(const IntegerView& a, const IntegerView& b) {
+	if (a.negative() != b.negative()) { // Then exactly one of them is negative
+		return a.negative() ? -1 : 1;
+	}
+	int cmp = compare_magnitude(a.limbs(), a.size(), b.limbs(), b.size());
+	return a.negative() ? -cmp : cmp; // For negative numbers, a larger magnitude indicates less than
+}
+
+/** Returns true if a == b (otherwise returns false)
+*/
+bool operator==(const IntegerView& a, const IntegerView& b) {
+	return compare(a, b) == 0;
+}
+
+/** Returns true if a < b (otherwise returns false)
+*/
+bool operator<(const IntegerView& a, const IntegerView& b) {
+	return compare(a, b) < 0;
+}
+
+/** Adds value to lhs
+	@param lhs accumulator (updated in place)
+	@param value the value being added (may view lhs itself)
+	@return lhs
+*/
+Integer& operator+=(Integer& lhs, const IntegerView& value) {
+	if (value.size() != 0 && value.limbs() == lhs.limbs()) { // value views lhs, whose storage the sum may move
+		return lhs += value.to_integer();
+	}
+	INTEGER_STATS_SCOPE(add, std::max(lhs.size(), value.size()));
+	lhs.add_magnitude(value.limbs(), value.size(), value.negative());
+	return lhs;
+}
+
+/** Subtracts value from lhs
+	@param lhs accumulator (updated in place)
+	@param value the value being subtracted (may view lhs itself)
+	@return lhs
+*/
+Integer& operator-=(Integer& lhs, const IntegerView& value) {
+	if (value.size() != 0 && value.limbs() == lhs.limbs()) {
+		return lhs -= value.to_integer();
+	}
+	INTEGER_STATS_SCOPE(sub, std::max(lhs.size(), value.size()));
+	lhs.add_magnitude(value.limbs(), value.size(), !value.negative());
+	return lhs;
+}
+
+/** Default constructor of IntegerTable: no cells
+*/
+IntegerTable::IntegerTable() : offsets(1, 0) {
+}
+
+/** Returns the number of cells
+*/
+std::size_t IntegerTable::size() const {
+	return offsets.size() - 1;
+}
+
+/** Returns the number of limbs in the pool
+*/
+std::size_t IntegerTable::limbs() const {
+	return pool.size();
+}
+
+/** Returns the number of bytes of storage in use (not counting spare capacity)
+*/
+std::size_t IntegerTable::memory() const {
+	return pool.size() * sizeof(limb) + offsets.size() * sizeof(std::size_t) + signs.size() * sizeof(std::uint64_t);
+}
+
+/** Returns cell i
+	@param i index of the cell (below size())
+	@return a view of the cell, valid until the next append
+*/
+IntegerView IntegerTable::operator[](std::size_t i) const {
+	return IntegerView(pool.data() + offsets[i], offsets[i + 1] - offsets[i], (signs[i / 64] >> (i % 64)) & 1);
+}
+
+/** Reserves storage, so that appending up to cells cells of limbs limbs in total does not reallocate
+	@param cells number of cells
+	@param limbs total number of limbs of the cells
+*/
+void IntegerTable::reserve(std::size_t cells, std::size_t limbs) {
+	pool.reserve(limbs);
+	offsets.reserve(cells + 1);
+	signs.reserve((cells + 63) / 64);
+}
+
+/** Removes all cells, keeping the storage for the next ones
+*/
+void IntegerTable::clear() {
+	pool.clear();
+	offsets.assign(1, 0);
+	signs.clear();
+}
+
+/** Exchanges the contents (and storage) with other
+	@param other the other table
+*/
+void IntegerTable::swap(IntegerTable& other) {
+	pool.swap(other.pool);
+	offsets.swap(other.offsets);
+	signs.swap(other.signs);
+}
+
+/** Extends the pool by room limbs for a new cell; operands that are cells of this table are re-pointed if the pool moves
+	@param room largest possible length of the new cell
+	@param a operand (updated if it views this pool)
+	@param b operand (updated if it views this pool)
+	@return where the new cell starts
+*/
+limb* IntegerTable::open_cell(std::size_t room, IntegerView& a, IntegerView& b) {
+	const limb* old_begin = pool.data();
+	const limb* old_end = old_begin + pool.size();
+	std::size_t start = pool.size();
+	pool.resize(start + room);
+	if (pool.data() != old_begin) { // the pool moved
+		std::less<const limb*> before;
+		for (IntegerView* view : { &a, &b }) {
+			if (view->size() != 0 && !before(view->limbs(), old_begin) && before(view->limbs(), old_end)) {
+				*view = IntegerView(pool.data() + (view->limbs() - old_begin), view->size(), view->negative());
+			}
+		}
+	}
+	return pool.data() + start;
+}
+
+/** Records the new cell (started by open_cell): removes its leading zero limbs and sets its sign
+	@param length length of the result written by the kernels
+	@param negative sign of the result
+*/
+void IntegerTable::close_cell(std::size_t length, bool negative) {
+	std::size_t start = offsets.back();
+	while (length != 0 && pool[start + length - 1] == 0) {
+		--length;
+	}
+	pool.resize(start + length);
+	std::size_t i = size();
+	if (i % 64 == 0) {
+		signs.push_back(0);
+	}
+	if (negative && length != 0) { // zero is never negative
+		signs[i / 64] |= (std::uint64_t)1 << (i % 64);
+	}
+	offsets.push_back(start + length);
+}
+
+/** Appends a copy of a
+	@param a value (may be a cell of this table)
+*/
+void IntegerTable::append(const IntegerView& a) {
+	IntegerView source = a, unused;
+	limb* r = open_cell(source.size(), source, unused);
+	std::copy(source.limbs(), source.limbs() + source.size(), r);
+	close_cell(source.size(), source.negative());
+}
+
+/** Appends a + b
+	@param a (may be a cell of this table)
+	@param b (may be a cell of this table)
+*/
+void IntegerTable::append_sum(const IntegerView& a, const IntegerView& b) {
+	IntegerView x = a, y = b;
+	std::size_t length = std::max(x.size(), y.size());
+	limb* r = open_cell(length + 1, x, y);
+	std::copy(x.limbs(), x.limbs() + x.size(), r); // the rest of the room is zero
+	bool negative = x.negative();
+	r[length] = add_signed<BinaryLimbs>(r, x.size(), negative, y.limbs(), y.size(), y.negative());
+	close_cell(length + 1, negative);
+}
+
+/** Appends a - b
+	@param a (may be a cell of this table)
+	@param b (may be a cell of this table)
+*/
+void IntegerTable::append_difference(const IntegerView& a, const IntegerView& b) {
+	append_sum(a, IntegerView(b.limbs(), b.size(), b.size() != 0 && !b.negative()));
+}
+
+/** Appends a + x*y for a single limb y
+	@param a (may be a cell of this table)
+	@param x (may be a cell of this table)
+	@param y unsigned multiplier
+*/
+void IntegerTable::append_addmul_limb(const IntegerView& a, const IntegerView& x, limb y) {
+	if (x.size() == 0 || y == 0) {
+		append(a);
+		return;
+	}
+	const LimbKernels& kernels = limb_kernels();
+	IntegerView acc = a, factor = x;
+	std::size_t xn = factor.size(), an = acc.size();
+
+	if (an == 0 || acc.negative() == factor.negative()) { // Same sign: accumulate the product into a copy of a
+		std::size_t room = std::max(an, xn + 1) + 1;
+		limb* r = open_cell(room, acc, factor);
+		std::copy(acc.limbs(), acc.limbs() + an, r); // the rest of the room is zero
+		limb carry = kernels.addmul_1(r, factor.limbs(), xn, y);
+		for (std::size_t i = xn; carry; ++i) { // propagate the carry
+			r[i] += carry;
+			carry = (r[i] < carry);
+		}
+		close_cell(room, factor.negative());
+		return;
+	}
+
+	// Opposite signs: form the product in the scratch buffer, then add it
+	std::vector<limb>& product = product_scratch<std::vector<limb> >();
+	product.resize(xn + 1);
+	product[xn] = kernels.mul_1(product.data(), factor.limbs(), xn, y);
+	std::size_t pn = xn + (product[xn] != 0);
+	std::size_t length = std::max(an, pn);
+	limb* r = open_cell(length + 1, acc, factor);
+	std::copy(acc.limbs(), acc.limbs() + an, r); // the rest of the room is zero
+	bool negative = acc.negative();
+	r[length] = add_signed<BinaryLimbs>(r, an, negative, product.data(), pn, factor.negative());
+	close_cell(length + 1, negative);
+}
+
+/** Appends a - x*y for a single limb y
+	@param a (may be a cell of this table)
+	@param x (may be a cell of this table)
+	@param y unsigned multiplier
+*/
+void IntegerTable::append_submul_limb(const IntegerView& a, const IntegerView& x, limb y) {
+	append_addmul_limb(a, IntegerView(x.limbs(), x.size(), x.size() != 0 && !x.negative()), y);
+}
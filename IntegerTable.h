@@ -0,0 +1,98 @@
+/** @file IntegerTable.h
+	@brief A column of Integers packed into one contiguous limb pool, for tables with millions of cells
+
+	IntegerTable stores its cells one after another in a single vector of limbs, with an offset per cell and a
+	bitmap of the signs (one bit per cell); the length of cell i is offsets[i + 1] - offsets[i]. A cell costs
+	its limbs, one offset and one bit, instead of an Integer (a heap block and a vector per cell), and a scan
+	over the cells reads memory in order.
+
+	Cells are read through IntegerView, a pointer to the limbs with the length and the sign; an IntegerView
+	can also be taken of an Integer. Cells are only ever added at the end (append-only), either as a copy of
+	a value or as the result of arithmetic on views, which is computed straight into the pool:
+	append(a);								cell = a
+	append_sum(a, b); append_difference(a, b);	cell = a + b; cell = a - b
+	append_addmul_limb(a, x, y);				cell = a + x*y (y a single limb)
+	append_submul_limb(a, x, y);				cell = a - x*y
+	The operands may be cells of the same table: they stay valid while the pool grows. Any other view of a
+	cell is invalidated by the next append (as with iterators of a std::vector). A view can also be added to
+	(or subtracted from) an Integer in place, e.g. to sum many cells: sum += table[i];
+*/
+
+#ifndef INTEGER_TABLE_H
+#define INTEGER_TABLE_H
+
+#include "Integer.h"
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+/** @class IntegerView
+	@brief Read-only view of an integer stored elsewhere (a cell of an IntegerTable or an Integer)
+*/
+class IntegerView {
+public:
+	typedef Integer::limb limb;
+
+	IntegerView();								   // Zero
+	IntegerView(const limb* limbs, std::size_t size, bool negative); // Magnitude limbs[0..size), without leading zeros
+	IntegerView(const Integer& value);			   // Views the limbs of value (valid while value is unchanged)
+
+	const limb* limbs() const; // Magnitude, least significant limb first
+	std::size_t size() const;	 // Number of limbs (zero has none)
+	bool negative() const;	 // True if the value is below zero
+
+	Integer to_integer() const;					// Copies the value into an Integer
+	void print_as_int(std::ostream& out) const; // Prints the value in base 10
+
+private:
+	const limb* data;
+	std::size_t length;
+	bool sign; // 1 indicates negative
+};
+
+std::ostream& operator<<(std::ostream& out, const IntegerView& value); // Prints value in base 10
+void write_binary(std::ostream& out, const IntegerView& value);			// Writes value in the format of write_binary(Integer)
+
+int compare(const IntegerView& a, const IntegerView& b);		  // -1, 0 or 1 as a < b, a == b or a > b
+bool operator==(const IntegerView& a, const IntegerView& b); // True if a == b
+bool operator<(const IntegerView& a, const IntegerView& b);	 // True if a < b
+
+Integer& operator+=(Integer& lhs, const IntegerView& value); // Adds value to lhs (without copying value into an Integer)
+Integer& operator-=(Integer& lhs, const IntegerView& value); // Subtracts value from lhs
+
+/** @class IntegerTable
+	@brief Append-only sequence of integers sharing one limb pool (see file description)
+*/
+class IntegerTable {
+public:
+	typedef Integer::limb limb;
+
+	IntegerTable();
+
+	std::size_t size() const;						// Number of cells
+	std::size_t limbs() const;						// Number of limbs in the pool
+	std::size_t memory() const;						// Bytes of storage in use (pool, offsets and signs)
+	IntegerView operator[](std::size_t i) const;	// Cell i (valid until the next append)
+
+	void reserve(std::size_t cells, std::size_t limbs); // Reserves storage for cells cells of limbs limbs in total
+	void clear();										   // Removes all cells (keeps the storage)
+	void swap(IntegerTable& other);						   // Exchanges the contents with other
+
+	// Append-only construction: each appends one cell
+	void append(const IntegerView& a);											   // a
+	void append_sum(const IntegerView& a, const IntegerView& b);				   // a + b
+	void append_difference(const IntegerView& a, const IntegerView& b);		   // a - b
+	void append_addmul_limb(const IntegerView& a, const IntegerView& x, limb y); // a + x*y
+	void append_submul_limb(const IntegerView& a, const IntegerView& x, limb y); // a - x*y
+
+private:
+	limb* open_cell(std::size_t room, IntegerView& a, IntegerView& b); // Makes room for a new cell (keeping a and b valid)
+	void close_cell(std::size_t length, bool negative);					// Trims the new cell and records it
+
+	std::vector<limb> pool;				 // magnitudes of all cells, one after another
+	std::vector<std::size_t> offsets;	 // cell i is pool[offsets[i] .. offsets[i + 1])
+	std::vector<std::uint64_t> signs;	 // bit i: cell i is negative
+};
+
+#endif //Ends the include guard
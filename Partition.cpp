@@ -0,0 +1,345 @@
+/** @file Partition.cpp
+	@brief The partition function by the pentagonal number recurrence and by the Rademacher series (see Partition.h)
+
+The Rademacher series is summed in fixed point: an Integer x with b fractional bits stands for x / 2^b. Each
+product is truncated back to b bits, so each operation is off by about one unit in the last place. Term k is
+evaluated with b = z_k / ln 2 + guard bits; its cosh and sinh are about 2^(b - guard), so its absolute error is
+about 2^-guard (times the small factors that the error grows by on the way), and the guard bits are chosen so
+that the errors of all the terms add up to much less than 1/4.
+*/
+
+#include "Partition.h"
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+typedef Integer::limb limb;
+
+namespace {
+
+const double pi_double = 3.14159265358979323846;
+const double ln2_double = 0.69314718055994530942;
+
+/** Below this n, partition_number takes p(n) from the recurrence (and Rademacher's bound needs n > 1)
+*/
+const int rademacher_minimum = 100;
+
+/** Returns the number of bits of |x|
+	@return 0 for zero
+*/
+std::size_t bit_length(const Integer& x) {
+	if (x.size() == 0) {
+		return 0;
+	}
+	return x.size() * 64 - __builtin_clzll(x.limbs()[x.size() - 1]);
+}
+
+/** Converts a fixed point number to the nearest double (about)
+	@param x fixed point number
+	@param bits number of fractional bits of x
+	@return x / 2^bits
+*/
+double to_double(const Integer& x, unsigned bits) {
+	std::size_t length = bit_length(x);
+	if (length == 0) {
+		return 0;
+	}
+	unsigned shift = length > 64 ? (unsigned)(length - 64) : 0; // keeps the top 64 bits
+	Integer top = x >> shift;
+	double value = std::ldexp((double)top.limbs()[0], (int)shift - (int)bits);
+	return x.negative() ? -value : value;
+}
+
+/** Converts a double to fixed point
+	@param value finite double
+	@param bits number of fractional bits of the result
+	@return value 2^bits (truncated)
+*/
+Integer from_double(double value, unsigned bits) {
+	int exponent;
+	double fraction = std::frexp(std::fabs(value), &exponent); // |value| = fraction 2^exponent
+	Integer x = Integer::from_limb((limb)std::ldexp(fraction, 53));
+	int shift = exponent - 53 + (int)bits;
+	if (shift >= 0) {
+		x <<= (unsigned)shift;
+	}
+	else {
+		x >>= (unsigned)-shift;
+	}
+	return value < 0 ? -x : x;
+}
+
+/** Multiplies fixed point numbers
+	@param a fixed point number
+	@param b fixed point number
+	@param bits number of fractional bits of a, b and the result
+	@return a*b (truncated toward zero)
+*/
+Integer multiply(const Integer& a, const Integer& b, unsigned bits) {
+	Integer product = a * b;
+	product >>= bits;
+	return product;
+}
+
+/** Computes 1/x by Newton's iteration y <- y + y(1 - xy), which doubles the number of correct bits
+	@param x fixed point number (in the range of a double)
+	@param bits number of fractional bits of x and the result
+	@return 1/x
+*/
+Integer reciprocal(const Integer& x, unsigned bits) {
+	const Integer one = Integer(1) << bits;
+	Integer y = from_double(1 / to_double(x, bits), bits); // about 50 correct bits
+	for (unsigned correct = 40; correct <= bits; correct *= 2) {
+		y += multiply(y, one - multiply(x, y, bits), bits);
+	}
+	return y;
+}
+
+/** Computes sqrt(x) as x/sqrt(x), by Newton's iteration y <- y + y(1 - xy^2)/2 for 1/sqrt(x)
+	@param x positive fixed point number (in the range of a double)
+	@param bits number of fractional bits of x and the result
+	@return sqrt(x)
+*/
+Integer square_root(const Integer& x, unsigned bits) {
+	const Integer one = Integer(1) << bits;
+	Integer y = from_double(1 / std::sqrt(to_double(x, bits)), bits);
+	for (unsigned correct = 40; correct <= bits; correct *= 2) {
+		y += multiply(y, one - multiply(x, multiply(y, y, bits), bits), bits) >> 1;
+	}
+	return multiply(x, y, bits);
+}
+
+/** Computes atan(1/x) or atanh(1/x) from the series sum of (-1)^i / ((2i+1) x^(2i+1)) (without the signs for atanh)
+	@param x integer above 1
+	@param bits number of fractional bits of the result
+	@param hyperbolic true for atanh
+	@return atan(1/x) or atanh(1/x), with an error of a unit in the last place per term
+*/
+Integer arctan_inverse(limb x, unsigned bits, bool hyperbolic) {
+	Integer power = Integer(1) << bits;
+	power.divide_limb(x); // 1/x^(2i+1)
+	Integer sum = power;
+	for (limb i = 1; power.size() != 0; ++i) {
+		power.divide_limb(x * x);
+		Integer term = power;
+		term.divide_limb(2 * i + 1);
+		if (hyperbolic || i % 2 == 0) {
+			sum += term;
+		}
+		else {
+			sum -= term;
+		}
+	}
+	return sum;
+}
+
+/** Computes pi by Machin's formula pi = 16 atan(1/5) - 4 atan(1/239)
+	@param bits number of fractional bits of the result
+	@return pi
+*/
+Integer pi(unsigned bits) {
+	const unsigned extra = 32; // absorbs the error of the series
+	Integer value = (arctan_inverse(5, bits + extra, false) << 4) - (arctan_inverse(239, bits + extra, false) << 2);
+	return value >> extra;
+}
+
+/** Computes ln 2 = 2 atanh(1/3)
+	@param bits number of fractional bits of the result
+	@return ln 2
+*/
+Integer ln2(unsigned bits) {
+	const unsigned extra = 32;
+	return (arctan_inverse(3, bits + extra, true) << 1) >> extra;
+}
+
+/** Computes e^r for a small r from its Taylor series at r/2^h, squared h times
+	@param r fixed point number, |r| <= 1
+	@param bits number of fractional bits of r and the result
+	@return e^r
+*/
+Integer exponential(const Integer& r, unsigned bits) {
+	const unsigned halvings = (unsigned)std::sqrt((double)bits) / 2 + 4;
+	const unsigned work = bits + halvings + 16; // each squaring doubles the relative error
+	const Integer one = Integer(1) << work;
+	Integer x = r << (work - bits - halvings); // r/2^h, with work fractional bits
+	Integer sum = one, term = one;
+	for (limb i = 1; term.size() != 0; ++i) {
+		term = multiply(term, x, work);
+		term.divide_limb(i);
+		sum += term;
+	}
+	for (unsigned i = 0; i < halvings; ++i) { // e^(2y) = (e^y)^2
+		sum = multiply(sum, sum, work);
+	}
+	return sum >> (work - bits);
+}
+
+/** Computes cos t from the Taylor series at t/2^h and the double angle formula cos 2y = 2 cos^2 y - 1, h times
+	@param t fixed point number, 0 <= t <= 4
+	@param bits number of fractional bits of t and the result
+	@return cos t
+*/
+Integer cosine(const Integer& t, unsigned bits) {
+	const unsigned halvings = (unsigned)std::sqrt((double)bits) / 2 + 4;
+	const unsigned work = bits + 2 * halvings + 16; // each doubling multiplies the error by up to 4
+	const Integer one = Integer(1) << work;
+	Integer x = t << (work - bits - halvings);
+	Integer square = multiply(x, x, work);
+	Integer sum = one, term = one;
+	for (limb i = 1; term.size() != 0; ++i) {
+		term = multiply(term, square, work);
+		term.divide_limb((2 * i - 1) * (2 * i));
+		if (i % 2) {
+			sum -= term;
+		}
+		else {
+			sum += term;
+		}
+	}
+	for (unsigned i = 0; i < halvings; ++i) {
+		sum = (multiply(sum, sum, work) << 1) - one;
+	}
+	return sum >> (work - bits);
+}
+
+/** Returns the number of terms after which the remainder of the Rademacher series for p(n) is below 1/4,
+	from Rademacher's bound on the remainder after N terms:
+	44 pi^2 / (225 sqrt(3)) N^(-1/2) + pi sqrt(2) / 75 (N/(n-1))^(1/2) sinh(pi/N sqrt(2n/3))
+	@param n argument of p (above 1)
+	@return number of terms
+*/
+int rademacher_terms(int n) {
+	for (int N = 1; ; ++N) {
+		double remainder = 44 * pi_double * pi_double / (225 * std::sqrt(3.0)) / std::sqrt((double)N)
+			+ pi_double * std::sqrt(2.0) / 75 * std::sqrt(N / (n - 1.0)) * std::sinh(pi_double / N * std::sqrt(2.0 * n / 3));
+		if (remainder < 0.25) {
+			return N;
+		}
+	}
+}
+
+/** Finds the terms of Selberg's sum S_k(n): the l mod 2k with (3l^2+l)/2 = -n (mod k), each of which adds
+	(-1)^l cos(pi (6l+1) / (6k))
+	@param k index of the term of the Rademacher series
+	@param n argument of p
+	@return for each l, a in [0, 6k] with cos(pi a / (6k)) = cos(pi (6l+1) / (6k)), and whether it is subtracted
+*/
+std::vector<std::pair<limb, bool> > selberg_angles(limb k, limb n) {
+	std::vector<std::pair<limb, bool> > angles;
+	for (limb l = 0; l < 2 * k; ++l) {
+		if (((3 * l * l + l) / 2 + n) % k == 0) {
+			limb a = (6 * l + 1) % (12 * k);
+			if (a > 6 * k) { // cos(pi a / (6k)) = cos(2 pi - pi a / (6k))
+				a = 12 * k - a;
+			}
+			angles.push_back(std::make_pair(a, l % 2 == 1));
+		}
+	}
+	return angles;
+}
+
+}
+
+/** Computes p(0), ..., p(N) by Euler's pentagonal number recurrence
+	p(n) = sum over k >= 1 of (-1)^(k+1) (p(n - k(3k-1)/2) + p(n - k(3k+1)/2))	(p of a negative number is 0)
+	@param N largest argument
+	@return table whose cell n is p(n) (empty for N < 0)
+*/
+IntegerTable partition_numbers(int N) {
+	IntegerTable table;
+	if (N < 0) {
+		return table;
+	}
+	// p(n) has about pi sqrt(2n/3) / ln 2 bits, so the cells average about 2/3 of the size of p(N)
+	double bits = pi_double * std::sqrt(2.0 * N / 3) / ln2_double;
+	table.reserve((std::size_t)N + 1, (std::size_t)((2.0 / 3) * (N + 1.0) * (bits / 64 + 1)));
+
+	table.append(Integer(1)); // p(0) = 1
+	for (int n = 1; n <= N; ++n) {
+		Integer sum;
+		sum.reserve(table[n - 1].size() + 1);
+		for (long long k = 1; ; ++k) {
+			long long first = k * (3 * k - 1) / 2; // the generalized pentagonal numbers k(3k-1)/2 and k(3k+1)/2
+			if (first > n) {
+				break;
+			}
+			long long second = first + k;
+			if (k % 2) {
+				sum += table[(std::size_t)(n - first)];
+				if (second <= n) {
+					sum += table[(std::size_t)(n - second)];
+				}
+			}
+			else {
+				sum -= table[(std::size_t)(n - first)];
+				if (second <= n) {
+					sum -= table[(std::size_t)(n - second)];
+				}
+			}
+		}
+		table.append(sum);
+	}
+	return table;
+}
+
+/** Computes p(n) by the Hardy-Ramanujan-Rademacher series (see Partition.h)
+	@param n argument
+	@return p(n) (0 for n < 0)
+*/
+Integer partition_number(int n) {
+	if (n < 0) {
+		return 0;
+	}
+	if (n < rademacher_minimum) {
+		return partition_numbers(n)[(std::size_t)n].to_integer();
+	}
+
+	const int terms = rademacher_terms(n);
+	const unsigned guard = 64 + 2 * (unsigned)std::ceil(std::log2((double)terms)); // fractional bits of the sum
+	const limb denominator = 24 * (limb)n - 1;
+	const double z1 = pi_double * std::sqrt((double)denominator) / 6; // z_k = z_1 / k
+
+	// pi, ln 2 and sqrt(24n-1) to the precision of the first term; later terms take their leading bits
+	const unsigned top = (unsigned)(z1 / ln2_double) + 1 + guard;
+	const Integer pi_top = pi(top), ln2_top = ln2(top);
+	const Integer root_top = square_root(Integer::from_limb(denominator) << top, top);
+
+	Integer sum; // fixed point with guard fractional bits
+	for (int k = 1; k <= terms; ++k) {
+		std::vector<std::pair<limb, bool> > angles = selberg_angles((limb)k, (limb)n);
+		if (angles.empty()) { // A_k(n) = 0
+			continue;
+		}
+		const unsigned bits = (unsigned)(z1 / k / ln2_double) + 1 + guard;
+		const Integer pi_k = pi_top >> (top - bits), ln2_k = ln2_top >> (top - bits);
+
+		Integer selberg; // S_k(n)
+		for (const std::pair<limb, bool>& angle : angles) {
+			Integer t = pi_k * Integer::from_limb(angle.first);
+			t.divide_limb(6 * (limb)k);
+			if (angle.second) {
+				selberg -= cosine(t, bits);
+			}
+			else {
+				selberg += cosine(t, bits);
+			}
+		}
+
+		// z = m ln 2 + r, so e^z = 2^m e^r and e^-z = 2^-m / e^r
+		Integer z = multiply(pi_k, root_top >> (top - bits), bits);
+		z.divide_limb(6 * (limb)k);
+		unsigned m = (unsigned)std::floor(to_double(z, bits) / ln2_double);
+		Integer r = z - ln2_k * Integer::from_limb(m);
+		Integer power = exponential(r, bits);
+		Integer growth = power << m, decay = reciprocal(power, bits) >> m;
+
+		// 4 S_k(n) (cosh z - sinh z / z) / (24n - 1)
+		Integer term = ((growth + decay) >> 1) - multiply((growth - decay) >> 1, reciprocal(z, bits), bits);
+		term = multiply(term, selberg, bits) << 2;
+		term.divide_limb(denominator);
+		sum += term >> (bits - guard);
+	}
+	sum += Integer(1) << (guard - 1); // rounds to the nearest integer
+	return sum >> guard;
+}
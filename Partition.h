@@ -0,0 +1,27 @@
+/** @file Partition.h
+	@brief The partition function p(n), the number of ways to write n as a sum of positive integers
+
+	main.cpp computes p(n) as p(n, n) with the recurrence p(k, n) = p(k, n-k) + p(k-1, n), which takes
+	exponential time as a recursion (and O(n^2) additions as a table). Two faster methods are provided:
+	1. partition_numbers: all of p(0), ..., p(N) from Euler's pentagonal number theorem,
+		p(n) = sum over k >= 1 of (-1)^(k+1) (p(n - k(3k-1)/2) + p(n - k(3k+1)/2)),
+	   which has about 2 sqrt(2n/3) terms per value: O(N^1.5) additions in all.
+	2. partition_number: a single p(n) from the Hardy-Ramanujan-Rademacher series
+		p(n) = 4/(24n-1) sum over k >= 1 of S_k(n) (cosh(z_k) - sinh(z_k)/z_k),	z_k = pi sqrt(24n-1) / (6k),
+	   where S_k(n) = sum over l mod 2k with (3l^2+l)/2 = -n (mod k) of (-1)^l cos(pi (6l+1) / (6k)) is Selberg's
+	   form of the Kloosterman sum A_k(n) = sqrt(k/3) S_k(n). The number of terms comes from Rademacher's bound on
+	   the remainder. Each term is evaluated in fixed point (an Integer scaled by a power of two) with just enough
+	   bits for its size, about z_k / ln 2, plus guard bits, so that the sum is within 1/4 of p(n) and rounds to it.
+	   The first term has about pi sqrt(2n/3) / ln 2 bits (3700 for n = 10^6) and later terms get quickly smaller.
+*/
+
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include "Integer.h"
+#include "IntegerTable.h"
+
+IntegerTable partition_numbers(int N); // p(0), ..., p(N) (cell n is p(n)) by the pentagonal number recurrence
+Integer partition_number(int n);		 // p(n) by the Hardy-Ramanujan-Rademacher series (0 for n < 0)
+
+#endif //Ends the include guard
@@ -0,0 +1,286 @@
+/** @file StirlingRow.cpp
+	@brief Rows of Stirling numbers by polynomial product trees and Kronecker substitution (see StirlingRow.h)
+*/
+
+#include "StirlingRow.h"
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+typedef Integer::limb limb;
+typedef std::vector<Integer> Polynomial; // the coefficient of x^i is at index i
+
+namespace {
+
+/** Products where one factor has fewer coefficients than this are formed term by term instead of packed
+*/
+const std::size_t kronecker_minimum = 8;
+
+/** Number of linear factors that a leaf of the falling factorial product tree multiplies in one at a time
+*/
+const int leaf_factors = 16;
+
+/** Returns the number of bits of |x|
+	@return 0 for zero
+*/
+std::size_t bit_length(const Integer& x) {
+	if (x.size() == 0) {
+		return 0;
+	}
+	return x.size() * 64 - __builtin_clzll(x.limbs()[x.size() - 1]);
+}
+
+/** Returns the number of bits of the largest coefficient of p (in absolute value)
+*/
+std::size_t max_bit_length(const Polynomial& p) {
+	std::size_t bits = 0;
+	for (const Integer& coefficient : p) {
+		bits = std::max(bits, bit_length(coefficient));
+	}
+	return bits;
+}
+
+/** Packs the magnitudes of the coefficients of one sign into slots of slot limbs
+	@param p polynomial
+	@param slot limbs per coefficient (more than any coefficient has)
+	@param negative which coefficients are packed (the others are left as zero)
+	@return the sum of |p[i]| 2^(64 slot i) over those coefficients
+*/
+Integer pack(const Polynomial& p, std::size_t slot, bool negative) {
+	std::vector<limb> limbs(p.size() * slot, 0);
+	for (std::size_t i = 0; i < p.size(); ++i) {
+		if (p[i].size() != 0 && p[i].negative() == negative) {
+			std::copy(p[i].limbs(), p[i].limbs() + p[i].size(), limbs.begin() + i * slot);
+		}
+	}
+	return Integer::from_limbs(limbs.data(), limbs.size(), false);
+}
+
+/** Unpacks the coefficients of a product of packed polynomials (the inverse of packing)
+	A slot whose top bit is set holds a negative coefficient: its value is the slot minus 2^(64 slot), and the
+	2^(64 slot) is borrowed from the next slot.
+	@param value the product
+	@param slot limbs per coefficient (each coefficient is below 2^(64 slot - 1) in absolute value)
+	@param count number of coefficients
+	@return the polynomial whose value at x = 2^(64 slot) is value
+*/
+Polynomial unpack(const Integer& value, std::size_t slot, std::size_t count) {
+	Polynomial p(count);
+	const limb* v = value.limbs();
+	std::size_t vn = value.size();
+	std::vector<limb> digit(slot);
+	limb carry = 0; // borrowed by the slot below
+	for (std::size_t i = 0; i < count; ++i) {
+		for (std::size_t j = 0; j < slot; ++j) {
+			std::size_t index = i * slot + j;
+			limb sum = (index < vn ? v[index] : 0) + carry;
+			carry = (sum < carry);
+			digit[j] = sum;
+		}
+		bool negative = digit[slot - 1] >> 63;
+		if (negative) { // the coefficient is digit - 2^(64 slot): its magnitude is the two's complement of digit
+			limb one = 1;
+			for (std::size_t j = 0; j < slot; ++j) {
+				digit[j] = ~digit[j] + one;
+				one = (one && digit[j] == 0);
+			}
+			carry = 1;
+		}
+		p[i] = Integer::from_limbs(digit.data(), slot, negative != value.negative());
+	}
+	return p;
+}
+
+/** Multiplies polynomials (by Kronecker substitution, unless one of them is short)
+	@param a polynomial
+	@param b polynomial
+	@return a*b
+*/
+Polynomial multiply(const Polynomial& a, const Polynomial& b) {
+	if (a.empty() || b.empty()) {
+		return Polynomial();
+	}
+	std::size_t count = a.size() + b.size() - 1;
+	std::size_t terms = std::min(a.size(), b.size());
+	if (terms < kronecker_minimum) {
+		Polynomial c(count);
+		for (std::size_t i = 0; i < a.size(); ++i) {
+			for (std::size_t j = 0; j < b.size(); ++j) {
+				addmul(c[i + j], a[i], b[j]);
+			}
+		}
+		return c;
+	}
+
+	// Each coefficient of a*b is a sum of at most terms products: |c| < terms max|a| max|b|, plus a sign bit
+	std::size_t bits = max_bit_length(a) + max_bit_length(b) + bit_length(Integer::from_limb(terms)) + 1;
+	std::size_t slot = bits / 64 + 1;
+	Integer packed_a = pack(a, slot, false) - pack(a, slot, true);
+	Integer packed_b = pack(b, slot, false) - pack(b, slot, true);
+	return unpack(packed_a * packed_b, slot, count);
+}
+
+/** Computes (x - lo)(x - lo - 1)...(x - hi + 1) as a balanced product tree
+	@param lo first root
+	@param hi one past the last root
+	@return the product (1 for lo == hi)
+*/
+Polynomial falling_factorial(int lo, int hi) {
+	if (hi - lo <= leaf_factors) {
+		Polynomial p(1, Integer(1));
+		for (int i = lo; i < hi; ++i) { // p *= x - i: p[j] becomes p[j-1] - i p[j]
+			p.push_back(Integer());
+			for (std::size_t j = p.size() - 1; j > 0; --j) {
+				Integer coefficient = p[j - 1];
+				submul_limb(coefficient, p[j], (limb)i);
+				p[j] = std::move(coefficient);
+			}
+			Integer constant;
+			submul_limb(constant, p[0], (limb)i);
+			p[0] = std::move(constant);
+		}
+		return p;
+	}
+	int mid = lo + (hi - lo) / 2;
+	return multiply(falling_factorial(lo, mid), falling_factorial(mid, hi));
+}
+
+/** Returns x mod 2^bits
+	@return a value in [0, 2^bits)
+*/
+Integer low_bits(const Integer& x, std::size_t bits) {
+	std::size_t limbs = (bits + 63) / 64;
+	std::vector<limb> low(x.limbs(), x.limbs() + std::min(x.size(), limbs));
+	if (low.size() == limbs && bits % 64 != 0) {
+		low.back() &= ((limb)1 << (bits % 64)) - 1;
+	}
+	Integer result = Integer::from_limbs(low.data(), low.size(), false);
+	if (x.negative() && result.size() != 0) {
+		result = (Integer(1) << (unsigned)bits) - result;
+	}
+	return result;
+}
+
+/** Computes the inverse of an odd d modulo 2^bits by Newton's iteration y <- y(2 - dy), which doubles the
+	number of correct low bits
+	@param d odd
+	@param bits precision
+	@return y with dy = 1 (mod 2^bits)
+*/
+Integer inverse_mod_power_of_2(const Integer& d, std::size_t bits) {
+	limb d0 = d.limbs()[0];
+	limb y0 = d0; // d^2 = 1 (mod 8)
+	for (int i = 0; i < 5; ++i) { // 6, 12, 24, 48, 96 correct bits
+		y0 *= 2 - d0 * y0;
+	}
+	Integer y = Integer::from_limb(y0);
+	for (std::size_t precision = 64; precision < bits; precision *= 2) {
+		std::size_t next = 2 * precision;
+		Integer product = low_bits(low_bits(d, next) * y, next);
+		y = low_bits(y * (Integer(2) - product), next);
+	}
+	return low_bits(y, bits);
+}
+
+/** Computes base^exponent by repeated squaring
+*/
+Integer power(limb base, int exponent) {
+	Integer result = 1, square = Integer::from_limb(base);
+	for (; exponent > 0; exponent /= 2) {
+		if (exponent % 2) {
+			result *= square;
+		}
+		if (exponent > 1) {
+			square *= square;
+		}
+	}
+	return result;
+}
+
+}
+
+/** Computes the row of Stirling numbers of the first kind for n, the coefficients of x(x-1)...(x-n+1)
+	@param n size (0 or more)
+	@return s(k, n) at index k, for 0 <= k <= n (empty for n < 0)
+*/
+std::vector<Integer> stirling1_row(int n) {
+	if (n < 0) {
+		return std::vector<Integer>();
+	}
+	return falling_factorial(0, n);
+}
+
+/** Computes the row of Stirling numbers of the second kind for n, from the convolution
+	(n!)^2 S(k, n) = sum over j of (j^n n!/j!) ((-1)^(k-j) n!/(k-j)!)
+	@param n size (0 or more)
+	@return S(k, n) at index k, for 0 <= k <= n (empty for n < 0)
+*/
+std::vector<Integer> stirling2_row(int n) {
+	if (n < 0) {
+		return std::vector<Integer>();
+	}
+	if (n == 0) {
+		return std::vector<Integer>(1, Integer(1)); // S(0, 0) = 1
+	}
+
+	// n!/j!, from n!/n! = 1 down to n!/0! = n!
+	std::vector<Integer> ratio(n + 1);
+	ratio[n] = 1;
+	for (int j = n; j > 0; --j) {
+		addmul_limb(ratio[j - 1], ratio[j], (limb)j);
+	}
+
+	// j^n n!/j!, where j^n = p^n (j/p)^n for the smallest prime factor p of j
+	std::vector<int> smallest_factor(n + 1, 0);
+	for (int j = 2; j <= n; ++j) {
+		if (smallest_factor[j] == 0) {
+			for (long long multiple = j; multiple <= n; multiple += j) {
+				if (smallest_factor[multiple] == 0) {
+					smallest_factor[multiple] = j;
+				}
+			}
+		}
+	}
+	Polynomial powers(n + 1), alternating(n + 1);
+	std::vector<Integer> power_sums(n / 2 + 1); // j^n, kept while a larger j may need it
+	for (int j = 1; j <= n; ++j) {
+		int p = smallest_factor[j];
+		Integer value = (j == 1) ? Integer(1) : (p == j) ? power((limb)j, n) : power_sums[p] * power_sums[j / p];
+		powers[j] = value * ratio[j];
+		if (j <= n / 2) {
+			power_sums[j] = std::move(value);
+		}
+	}
+	for (int i = 0; i <= n; ++i) {
+		alternating[i] = (i % 2) ? -ratio[i] : ratio[i];
+	}
+	Polynomial convolution = multiply(powers, alternating);
+	convolution.resize(n + 1);
+
+	// Exact division by (n!)^2 = 2^v d, d odd: S = (c / 2^v) / d, where dividing by d is multiplying by 1/d mod 2^w
+	Integer divisor = ratio[0] * ratio[0];
+	std::size_t v = 0;
+	while (divisor.limbs()[v / 64] == 0) {
+		v += 64;
+	}
+	v += __builtin_ctzll(divisor.limbs()[v / 64]);
+	divisor >>= (unsigned)v;
+	std::size_t divisor_bits = bit_length(divisor), width = 1;
+	for (Integer& c : convolution) {
+		c >>= (unsigned)v;
+		width = std::max(width, bit_length(c) + 1); // bound on the bits of a quotient, plus divisor_bits
+	}
+	width = width > divisor_bits ? width - divisor_bits : 1;
+	Integer inverse = inverse_mod_power_of_2(divisor, width);
+
+	std::vector<Integer> row(n + 1);
+	for (int k = 0; k <= n; ++k) {
+		std::size_t length = bit_length(convolution[k]);
+		if (length == 0) {
+			continue;
+		}
+		std::size_t bits = length + 1 > divisor_bits ? length + 1 - divisor_bits : 1; // S(k, n) < 2^bits
+		row[k] = low_bits(low_bits(convolution[k], bits) * low_bits(inverse, bits), bits);
+	}
+	return row;
+}
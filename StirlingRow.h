@@ -0,0 +1,30 @@
+/** @file StirlingRow.h
+	@brief A whole row of Stirling numbers for one n, without the rows before it
+
+	The recurrences of main.cpp (and of Table.h) reach s(k, n) and S(k, n) only through every row before n.
+	For a single n, the row can be computed directly:
+	1. stirling1_row: s(k, n) is the coefficient of x^k in the falling factorial x(x-1)...(x-n+1). The product is
+	   taken as a balanced product tree of the n linear factors.
+	2. stirling2_row: S(k, n) = sum over j of (-1)^(k-j) j^n / (j! (k-j)!), which is the convolution of the power
+	   sums j^n / j! with the alternating inverse factorials (-1)^i / i!. Both are scaled by n! to make them
+	   integers, so the convolution gives (n!)^2 S(k, n), which is then divided exactly by (n!)^2 (2-adically:
+	   by multiplying with the inverse of the odd part of (n!)^2 modulo a power of two).
+	Every polynomial product is done by Kronecker substitution: each polynomial is packed into one Integer with
+	its coefficients in slots of a whole number of limbs, wide enough for the coefficients of the product (with a
+	sign bit), the two Integers are multiplied with one (Karatsuba or transform) multiplication, and the product is unpacked
+	slot by slot (a negative coefficient borrows from the next slot).
+
+	A row holds about n^2 log2(n) / 2 bits (n = 10^4: about 100 MB), and the Kronecker products need a few
+	times that while they run.
+*/
+
+#ifndef STIRLING_ROW_H
+#define STIRLING_ROW_H
+
+#include "Integer.h"
+#include <vector>
+
+std::vector<Integer> stirling1_row(int n); // s(0, n), ..., s(n, n): signed Stirling numbers of the first kind
+std::vector<Integer> stirling2_row(int n); // S(0, n), ..., S(n, n): Stirling numbers of the second kind
+
+#endif //Ends the include guard
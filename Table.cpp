@@ -0,0 +1,687 @@
+/** @file Table.cpp
+	@brief Row-by-row generation of the Partition and Stirling tables (see Table.h)
+
+Multi-modular mode:
+1. Primes: the largest primes below 2^62, as many as are needed for their product to exceed 2*2^bound
+   (the factor 2 leaves room for the sign of s(k, n)).
+2. Residues: the rows are generated in blocks. For each block, every prime is an independent task that
+   advances its own residue row; the multipliers n-1 (s) and k (S) are precomputed for Shoup's
+   multiplication, so the inner loops are one or two word multiplications per cell.
+3. Reconstruction: each cell is rebuilt from its residues with Garner's mixed-radix algorithm, which only
+   needs word arithmetic and in-place Integer multiplications by a limb. The cells of a block are reconstructed
+   in parallel, a range of cells per work item (so a block of a single row still uses every thread), and
+   written in order. The same worker threads serve every block of the table.
+
+Checkpoint file: the words checkpoint_magic, checkpoint_version, kind, m, mode, rows written and output position,
+followed by the frontier: row k (m + 1 values, write_binary) in the full-precision modes, or the residue rows of
+the primes (m + 1 words each, largest prime first) in the multi-modular mode.
+*/
+
+#include "Table.h"
+#include "Checkpoint.h"
+#include "Integer.h"
+#include "DecimalInteger.h"
+#include "IntegerTable.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef Integer::limb limb;
+typedef unsigned __int128 dlimb; // Holds the product of two limbs
+
+namespace {
+
+/** Advances a full-precision row: next = row k computed from row = row k-1
+	@tparam Number Integer or DecimalInteger
+	@param kind table being generated
+	@param k index of the new row
+	@param row row k-1 (entries 0..m)
+	@param next receives row k (its Integers are reused: each cell is copied into the limbs it already has, also
+	with INTEGER_COW, so steady state does not allocate)
+*/
+template <class Number>
+void advance_row(Table kind, int k, const std::vector<Number>& row, std::vector<Number>& next) {
+	std::size_t m = row.size() - 1;
+	next[0] = (kind == Table::partition) ? 1 : 0; // p(k, 0) = 1; s(k, 0) = S(k, 0) = 0
+	for (std::size_t n = 1; n <= m; ++n) {
+		switch (kind) {
+		case Table::partition: // p(k, n) = p(k, n-k) + p(k-1, n), where p(k, n-k) = 0 for n < k
+			next[n].copy_from(row[n]);
+			if (n >= (std::size_t)k) {
+				next[n] += next[n - k];
+			}
+			break;
+		case Table::stirling1: // s(k, n) = -(n-1) s(k, n-1) + s(k-1, n-1)
+			next[n].copy_from(row[n - 1]);
+			submul_limb(next[n], next[n - 1], n - 1);
+			break;
+		case Table::stirling2: // S(k, n) = kS(k, n-1) + S(k-1, n-1)
+			next[n].copy_from(row[n - 1]);
+			addmul_limb(next[n], next[n - 1], k);
+			break;
+		}
+	}
+}
+
+/** Returns (a*b) mod p
+*/
+limb mulmod(limb a, limb b, limb p) {
+	return (limb)((dlimb)a * b % p);
+}
+
+/** Returns (a^e) mod p
+*/
+limb powmod(limb a, limb e, limb p) {
+	limb result = 1;
+	while (e) {
+		if (e & 1) {
+			result = mulmod(result, a, p);
+		}
+		a = mulmod(a, a, p);
+		e >>= 1;
+	}
+	return result;
+}
+
+/** Deterministic Miller-Rabin test for 64-bit odd n > 37
+	@return true if n is prime
+*/
+bool is_prime(limb n) {
+	limb d = n - 1;
+	int r = 0;
+	while ((d & 1) == 0) {
+		d >>= 1;
+		++r;
+	}
+	const limb witnesses[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37 };
+	for (limb a : witnesses) {
+		limb x = powmod(a, d, n);
+		if (x == 1 || x == n - 1) {
+			continue;
+		}
+		bool composite = true;
+		for (int i = 1; i < r && composite; ++i) {
+			x = mulmod(x, x, n);
+			composite = (x != n - 1);
+		}
+		if (composite) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/** Returns the count largest primes below 2^62, in decreasing order
+*/
+std::vector<limb> largest_primes(std::size_t count) {
+	std::vector<limb> primes;
+	for (limb candidate = ((limb)1 << 62) - 1; primes.size() < count; candidate -= 2) {
+		if (is_prime(candidate)) {
+			primes.push_back(candidate);
+		}
+	}
+	return primes;
+}
+
+/** @class Multiplier
+	@brief A fixed factor w mod p with its Shoup precomputation floor(w*2^64/p)
+*/
+struct Multiplier {
+	limb w;
+	limb w_shoup;
+};
+
+Multiplier multiplier(limb w, limb p) {
+	w %= p;
+	return { w, (limb)(((dlimb)w << 64) / p) };
+}
+
+/** Returns (a*m.w) mod p for a < p < 2^63
+*/
+inline limb mul(limb a, Multiplier m, limb p) {
+	limb q = (limb)(((dlimb)a * m.w_shoup) >> 64);
+	limb r = a * m.w - q * p;
+	return r >= p ? r - p : r;
+}
+
+inline limb add(limb a, limb b, limb p) {
+	limb s = a + b;
+	return s >= p ? s - p : s;
+}
+
+inline limb sub(limb a, limb b, limb p) {
+	return a >= b ? a - b : a + p - b;
+}
+
+/** @class ResidueTask
+	@brief The residue row of one prime, advanced a block of rows at a time
+*/
+struct ResidueTask {
+	limb p;
+	std::vector<limb> row;				// residues of row k-1 (advanced in place to row k)
+	std::vector<Multiplier> column;	// n-1 mod p, for s(k, n)
+
+	/** Advances rows first..last-1 and stores residues of columns 1..m in out[(k - first)*m + n - 1]
+	*/
+	void advance(Table kind, int first, int last, limb* out) {
+		std::size_t m = row.size() - 1;
+		for (int k = first; k < last; ++k) {
+			switch (kind) {
+			case Table::partition: // in place: row[n] += row[n-k]
+				for (std::size_t n = k; n <= m; ++n) {
+					row[n] = add(row[n], row[n - k], p);
+				}
+				break;
+			case Table::stirling1: {
+				limb previous = row[0]; // s(k-1, n-1) before it is overwritten
+				row[0] = 0;
+				for (std::size_t n = 1; n <= m; ++n) {
+					limb old = row[n];
+					row[n] = sub(previous, mul(row[n - 1], column[n], p), p);
+					previous = old;
+				}
+				break;
+			}
+			case Table::stirling2: {
+				Multiplier factor = multiplier(k, p);
+				limb previous = row[0];
+				row[0] = 0;
+				for (std::size_t n = 1; n <= m; ++n) {
+					limb old = row[n];
+					row[n] = add(mul(row[n - 1], factor, p), previous, p);
+					previous = old;
+				}
+				break;
+			}
+			}
+			std::copy(row.begin() + 1, row.end(), out + (std::size_t)(k - first) * m);
+		}
+	}
+};
+
+/** @class WorkerPool
+	@brief Worker threads kept for a whole table: each run calls work(t) for t = 0..size-1 (t = 0 on the caller)
+*/
+class WorkerPool {
+public:
+	/** Starts size - 1 worker threads
+	*/
+	explicit WorkerPool(unsigned size) {
+		for (unsigned t = 1; t < size; ++t) {
+			workers.emplace_back(&WorkerPool::serve, this, t);
+		}
+	}
+
+	/** Stops and joins the workers
+	*/
+	~WorkerPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		start.notify_all();
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+	}
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	/** Runs work(t) on every thread of the pool, and returns when all of them have finished
+	*/
+	void run(const std::function<void(unsigned)>& work) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			current = &work;
+			running = workers.size();
+			++generation;
+		}
+		start.notify_all();
+		work(0);
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.wait(lock, [this] { return running == 0; });
+	}
+
+private:
+	/** Body of worker t: runs each new work until the pool stops
+	*/
+	void serve(unsigned t) {
+		std::size_t seen = 0; // generation of the last work run
+		for (;;) {
+			const std::function<void(unsigned)>* work;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				start.wait(lock, [&] { return stopping || generation != seen; });
+				if (stopping) {
+					return;
+				}
+				seen = generation;
+				work = current;
+			}
+			(*work)(t);
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--running == 0) {
+				finished.notify_one();
+			}
+		}
+	}
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable start;		// a new work, or stopping
+	std::condition_variable finished;	// running dropped to 0
+	const std::function<void(unsigned)>* current = nullptr; // the work of the current run
+	std::size_t generation = 0;			// number of runs started
+	std::size_t running = 0;			// workers still in the current run
+	bool stopping = false;
+};
+
+const std::uint64_t checkpoint_magic = 0x496e745461626c65; // "IntTable"
+const std::uint64_t checkpoint_version = 1;
+
+/** @enum CheckpointMode
+	@brief How the frontier in a checkpoint was computed (a checkpoint only resumes the same mode)
+*/
+enum class CheckpointMode : std::uint64_t {
+	binary,
+	decimal,
+	modular,
+	packed
+};
+
+/** @class Checkpointer
+	@brief Saves the frontier of one table job in the background, and restores it (see Table.h)
+*/
+class Checkpointer {
+public:
+	Checkpointer(const TableCheckpoint& options, Table kind, int m, CheckpointMode mode, std::ostream& out)
+		: options(options), kind(kind), m(m), mode(mode), out(out), last_save(std::chrono::steady_clock::now()) {
+		if (!options.path.empty()) {
+			writer.reset(new CheckpointWriter(options.path, options.output));
+		}
+	}
+
+	/** Resumes from the checkpoint, if resume is set and the checkpoint belongs to this job
+		@param read reads the frontier; it must leave the job unchanged if it returns false
+		@return number of rows already written (0: start from the first row); out is positioned after them
+	*/
+	template <class Read>
+	int restore(Read read) {
+		if (!writer || !options.resume) {
+			return 0;
+		}
+		std::ifstream in(options.path, std::ios::binary);
+		if (!in) {
+			std::cerr << "No checkpoint " << options.path << "; starting from the first row" << std::endl;
+			return 0;
+		}
+		std::uint64_t header[7];
+		for (std::uint64_t& word : header) {
+			if (!read_word(in, word)) {
+				header[0] = 0;
+				break;
+			}
+		}
+		if (header[0] != checkpoint_magic || header[1] != checkpoint_version || header[2] != (std::uint64_t)kind
+			|| header[3] != (std::uint64_t)m || header[4] != (std::uint64_t)mode || header[5] > (std::uint64_t)m) {
+			std::cerr << "Checkpoint " << options.path << " is not from this table job; starting from the first row" << std::endl;
+			return 0;
+		}
+		if (!out.seekp((std::streamoff)header[6])) {
+			out.clear();
+			std::cerr << "Cannot position the output for checkpoint " << options.path << "; starting from the first row" << std::endl;
+			return 0;
+		}
+		if (!read(in)) {
+			out.seekp(0);
+			std::cerr << "Checkpoint " << options.path << " is cut short; starting from the first row" << std::endl;
+			return 0;
+		}
+		return (int)header[5];
+	}
+
+	/** Called after row k has been written: saves the frontier when the interval has passed, unless the previous
+		save is still in progress (the computation never waits for a save, except after the last row)
+		@param k rows written
+		@param snapshot returns a function that writes a copy of the frontier (only called when saving)
+		@param last true after the last row: saves, and waits until the checkpoint is on disk
+	*/
+	template <class Snapshot>
+	void row_written(int k, Snapshot snapshot, bool last) {
+		if (!writer) {
+			return;
+		}
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - last_save;
+		if (!last && (elapsed.count() < options.interval || writer->busy())) {
+			return;
+		}
+		out.flush(); // the rows before the saved position must reach the file first (the writer syncs it to disk)
+		std::streamoff position = out.tellp();
+		if (position < 0) {
+			std::cerr << "The output cannot be positioned; no checkpoints are saved" << std::endl;
+			writer.reset();
+			return;
+		}
+		const std::uint64_t header[7] = { checkpoint_magic, checkpoint_version, (std::uint64_t)kind, (std::uint64_t)m,
+			(std::uint64_t)mode, (std::uint64_t)k, (std::uint64_t)position };
+		std::function<void(std::ostream&)> frontier = snapshot();
+		writer->save([header, frontier](std::ostream& file) {
+			for (std::uint64_t word : header) {
+				write_word(file, word);
+			}
+			frontier(file);
+		});
+		last_save = std::chrono::steady_clock::now();
+		if (last && !writer->wait()) {
+			std::cerr << "Could not save checkpoint " << options.path << std::endl;
+		}
+	}
+
+private:
+	const TableCheckpoint& options;
+	Table kind;
+	int m;
+	CheckpointMode mode;
+	std::ostream& out;
+	std::unique_ptr<CheckpointWriter> writer; // null without checkpoints
+	std::chrono::steady_clock::time_point last_save;
+};
+
+/** Writes the m x m table, computing each row from the previous one in full precision
+	@tparam Number Integer or DecimalInteger
+	@param kind table being generated
+	@param m number of rows and columns
+	@param out destination (e.g. Partition.txt)
+	@param checkpointer saves and restores the last row
+*/
+template <class Number>
+void write_rows(Table kind, int m, std::ostream& out, Checkpointer& checkpointer) {
+	std::vector<Number> row(m + 1), next(m + 1);
+	row[0] = 1; // row 0: T(0, 0) = 1 and T(0, n) = 0 for n > 0
+
+	int done = checkpointer.restore([&](std::istream& in) {
+		std::vector<Number> saved(m + 1);
+		for (Number& value : saved) {
+			if (!read_binary(in, value)) {
+				return false;
+			}
+		}
+		row.swap(saved);
+		return true;
+	});
+
+	for (int k = done + 1; k <= m; ++k) { // Generate kth row
+		advance_row(kind, k, row, next);
+		row.swap(next);
+		for (int n = 1; n <= m; ++n) { // Write nth entry (column)
+			out << row[n] << " ";
+		}
+		out << "\n"; // Go to next row
+
+		checkpointer.row_written(k, [&] {
+			std::shared_ptr<const std::vector<Number> > copy = std::make_shared<const std::vector<Number> >(row);
+			return [copy](std::ostream& file) {
+				for (const Number& value : *copy) {
+					write_binary(file, value);
+				}
+			};
+		}, k == m);
+	}
+}
+
+
+/** Writes the m x m table like write_rows, with each row packed in an IntegerTable
+	@param kind table being generated
+	@param m number of rows and columns
+	@param out destination (e.g. Partition.txt)
+	@param checkpointer saves and restores the last row
+*/
+void write_rows_packed(Table kind, int m, std::ostream& out, Checkpointer& checkpointer) {
+	const Integer one = 1;
+	IntegerTable row, next;
+	row.append(one); // row 0: T(0, 0) = 1 and T(0, n) = 0 for n > 0
+	for (int n = 1; n <= m; ++n) {
+		row.append(IntegerView());
+	}
+
+	int done = checkpointer.restore([&](std::istream& in) {
+		IntegerTable saved;
+		Integer value;
+		for (int n = 0; n <= m; ++n) {
+			if (!read_binary(in, value)) {
+				return false;
+			}
+			saved.append(value);
+		}
+		row.swap(saved);
+		return true;
+	});
+
+	for (int k = done + 1; k <= m; ++k) { // Generate kth row
+		next.clear();
+		next.append(kind == Table::partition ? IntegerView(one) : IntegerView()); // p(k, 0) = 1; s(k, 0) = S(k, 0) = 0
+		for (int n = 1; n <= m; ++n) {
+			switch (kind) {
+			case Table::partition: // p(k, n) = p(k, n-k) + p(k-1, n), where p(k, n-k) = 0 for n < k
+				if (n >= k) {
+					next.append_sum(row[n], next[n - k]);
+				}
+				else {
+					next.append(row[n]);
+				}
+				break;
+			case Table::stirling1: // s(k, n) = -(n-1) s(k, n-1) + s(k-1, n-1)
+				next.append_submul_limb(row[n - 1], next[n - 1], n - 1);
+				break;
+			case Table::stirling2: // S(k, n) = kS(k, n-1) + S(k-1, n-1)
+				next.append_addmul_limb(row[n - 1], next[n - 1], k);
+				break;
+			}
+		}
+		row.swap(next);
+		for (int n = 1; n <= m; ++n) { // Write nth entry (column)
+			out << row[n] << " ";
+		}
+		out << "\n"; // Go to next row
+
+		checkpointer.row_written(k, [&] {
+			std::shared_ptr<const IntegerTable> copy = std::make_shared<const IntegerTable>(row);
+			return [copy](std::ostream& file) {
+				for (std::size_t n = 0; n < copy->size(); ++n) {
+					write_binary(file, (*copy)[n]);
+				}
+			};
+		}, k == m);
+	}
+}
+}
+
+/** Writes the m x m table, computing each row from the previous one in full precision
+	@param kind table being generated
+	@param m number of rows and columns
+	@param out destination (e.g. Partition.txt)
+	@param representation number type used for the rows (the output is the same)
+	@param checkpoint checkpoint file, interval and resume flag
+*/
+void write_table(Table kind, int m, std::ostream& out, Representation representation, const TableCheckpoint& checkpoint) {
+	if (m < 1) {
+		return;
+	}
+	if (representation == Representation::decimal) {
+		Checkpointer checkpointer(checkpoint, kind, m, CheckpointMode::decimal, out);
+		write_rows<DecimalInteger>(kind, m, out, checkpointer);
+	}
+	else if (representation == Representation::packed) {
+		Checkpointer checkpointer(checkpoint, kind, m, CheckpointMode::packed, out);
+		write_rows_packed(kind, m, out, checkpointer);
+	}
+	else {
+		Checkpointer checkpointer(checkpoint, kind, m, CheckpointMode::binary, out);
+		write_rows<Integer>(kind, m, out, checkpointer);
+	}
+}
+
+/** Returns a bound on the number of bits of |T(k, n)| over the m x m table
+	@param kind table
+	@param m number of rows and columns
+	@return bound in bits
+*/
+std::size_t table_bit_bound(Table kind, int m) {
+	double bits;
+	if (kind == Table::partition) { // p(k, n) <= p(n) < exp(pi sqrt(2n/3))
+		bits = 3.14159265358979323846 * std::sqrt(2.0 * m / 3.0) / std::log(2.0);
+	}
+	else { // |s(k, n)| <= n! (the magnitudes sum to n!) and S(k, n) <= Bell(n) <= n!
+		bits = std::lgamma(m + 1.0) / std::log(2.0);
+	}
+	return (std::size_t)bits + 2;
+}
+
+/** Writes the m x m table using residues modulo 62-bit primes (see the file description)
+	@param kind table being generated
+	@param m number of rows and columns
+	@param out destination (e.g. Partition.txt)
+	@param threads number of worker threads (0: one per core)
+	@param checkpoint checkpoint file, interval and resume flag
+*/
+void write_table_modular(Table kind, int m, std::ostream& out, unsigned threads, const TableCheckpoint& checkpoint) {
+	if (m < 1) {
+		return;
+	}
+	if (threads == 0) {
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	// 1. Primes: their product M must exceed 2*2^bound; each prime exceeds 2^61
+	std::size_t count = (table_bit_bound(kind, m) + 1) / 61 + 1;
+	std::vector<limb> primes = largest_primes(count);
+
+	std::vector<ResidueTask> tasks(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		tasks[i].p = primes[i];
+		tasks[i].row.assign(m + 1, 0);
+		tasks[i].row[0] = 1; // row 0
+		if (kind == Table::stirling1) {
+			tasks[i].column.resize(m + 1);
+			for (int n = 1; n <= m; ++n) {
+				tasks[i].column[n] = multiplier(n - 1, primes[i]);
+			}
+		}
+	}
+
+	// Garner's constants: inverse[i][j] = p_j^(-1) mod p_i for j < i
+	std::vector<std::vector<Multiplier> > inverse(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		for (std::size_t j = 0; j < i; ++j) {
+			inverse[i].push_back(multiplier(powmod(primes[j] % primes[i], primes[i] - 2, primes[i]), primes[i]));
+		}
+	}
+	Integer product = 1; // M
+	for (limb p : primes) {
+		product *= Integer::from_limb(p);
+	}
+	Integer half = product >> 1;
+	const Integer one = 1;
+
+	Checkpointer checkpointer(checkpoint, kind, m, CheckpointMode::modular, out);
+	int done = checkpointer.restore([&](std::istream& in) {
+		std::vector<limb> saved(count * (m + 1));
+		for (std::size_t i = 0; i < saved.size(); ++i) {
+			std::uint64_t residue;
+			if (!read_word(in, residue) || residue >= primes[i / (m + 1)]) {
+				return false;
+			}
+			saved[i] = residue;
+		}
+		for (std::size_t i = 0; i < count; ++i) {
+			tasks[i].row.assign(saved.begin() + i * (m + 1), saved.begin() + (i + 1) * (m + 1));
+		}
+		return true;
+	});
+
+	// 2. Blocks of rows: the residues of a block take about 64 MB
+	std::size_t block = std::max<std::size_t>(1, ((std::size_t)1 << 26) / (count * m * sizeof(limb)));
+	std::size_t span = std::max<std::size_t>(1, 1024 / count); // cells per reconstruction work item
+	WorkerPool pool(threads);
+	std::vector<limb> residues;
+	std::vector<std::string> text;
+	for (int first = done + 1; first <= m; first += (int)block) {
+		int last = std::min(m + 1, first + (int)block);
+		std::size_t rows = last - first, cells = rows * m;
+		residues.resize(count * cells);
+
+		std::atomic<std::size_t> next_task(0);
+		pool.run([&](unsigned) {
+			for (std::size_t i; (i = next_task++) < count; ) {
+				tasks[i].advance(kind, first, last, &residues[i * cells]);
+			}
+		});
+
+		// 3. Reconstruction, span cells per work item
+		std::size_t items = (cells + span - 1) / span;
+		text.assign(items, std::string());
+		std::atomic<std::size_t> next_item(0);
+		pool.run([&](unsigned) {
+			std::vector<limb> digits(count);
+			Integer value; // reused by every cell, so it only allocates while it grows
+			value.reserve(count + 1);
+			std::ostringstream line;
+			for (std::size_t item; (item = next_item++) < items; ) {
+				line.str("");
+				for (std::size_t cell = item * span; cell < std::min(cells, (item + 1) * span); ++cell) {
+					for (std::size_t i = 0; i < count; ++i) { // mixed-radix digits
+						limb p = primes[i], v = residues[i * cells + cell];
+						for (std::size_t j = 0; j < i; ++j) {
+							limb d = digits[j] >= p ? digits[j] - p : digits[j]; // digits[j] < 2^62 < 2p
+							v = mul(sub(v, d, p), inverse[i][j], p);
+						}
+						digits[i] = v;
+					}
+					// Horner: value = d_0 + p_0 (d_1 + p_1 (d_2 + ...)), starting from zero at the top digit
+					for (std::size_t i = count; i-- > 0; ) {
+						value.mul_limb(i + 1 < count ? primes[i] : 0);
+						addmul_limb(value, one, digits[i]);
+					}
+					if (kind == Table::stirling1 && value > half) { // symmetric range: negative values
+						value -= product;
+					}
+					line << value << " ";
+					if (cell % m == (std::size_t)m - 1) { // last column of its row
+						line << "\n";
+					}
+				}
+				text[item] = line.str();
+			}
+		});
+
+		for (const std::string& item : text) {
+			out << item;
+		}
+
+		checkpointer.row_written(last - 1, [&] {
+			std::shared_ptr<std::vector<limb> > copy = std::make_shared<std::vector<limb> >();
+			for (const ResidueTask& task : tasks) {
+				copy->insert(copy->end(), task.row.begin(), task.row.end());
+			}
+			return [copy](std::ostream& file) {
+				for (limb residue : *copy) {
+					write_word(file, residue);
+				}
+			};
+		}, last - 1 == m);
+	}
+}
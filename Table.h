@@ -0,0 +1,72 @@
+/** @file Table.h
+	@brief Row-by-row generation of the Partition and Stirling tables written by main.cpp
+
+	Row k of a table holds T(k, 1), ..., T(k, m), separated (and followed) by a space, one row per line.
+	Every recurrence only looks back one row (or along the current row), so a row is computed from the
+	previous one:
+	Partition:						p(k, n) = p(k, n-k) + p(k-1, n)
+	Stirling numbers (1st kind):	s(k, n) = -(n-1) s(k, n-1) + s(k-1, n-1)
+	Stirling numbers (2nd kind):	S(k, n) = kS(k, n-1) + S(k-1, n-1)
+	starting from row 0: T(0, 0) = 1 and T(0, n) = 0 for n > 0.
+
+	Two modes are available:
+	1. write_table: the rows are computed in full precision, with Integers (binary limbs), with
+	   DecimalIntegers (base 10^19 limbs, which are printed without any division; see DecimalInteger.h), or
+	   in an IntegerTable per row (binary limbs packed in one pool; see IntegerTable.h);
+	2. write_table_modular: the rows are computed modulo several 62-bit primes, with machine-word arithmetic
+	   only, one independent task per prime. Each output cell is then reconstructed from its residues
+	   (Chinese remaindering). The number of primes comes from table_bit_bound.
+
+	Checkpoints: given a TableCheckpoint, both modes save their frontier every interval seconds while they
+	run, and once more at the end. Every recurrence only needs the previous row, so the frontier is the last
+	row written (its residues in the multi-modular mode). It is saved in binary, with the table, the mode and the
+	position of the output stream after that row, on a background thread (see Checkpoint.h); when the output file
+	is named in the TableCheckpoint, it is synced to disk before the checkpoint is put in place. With resume set, a
+	job that matches the checkpoint seeks the output back to that position and continues with the next row;
+	the rows are computed exactly as before, so the output file ends up identical to an uninterrupted run.
+	The output must be a seekable stream that was not truncated when it was opened for the resumed job.
+*/
+
+#ifndef TABLE_H
+#define TABLE_H
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+/** @enum Table
+	@brief The tables that can be generated
+*/
+enum class Table {
+	partition, // p(k, n)
+	stirling1, // s(k, n), signed
+	stirling2  // S(k, n)
+};
+
+/** @enum Representation
+	@brief The number type that write_table computes the rows with
+*/
+enum class Representation {
+	binary, // Integer
+	decimal, // DecimalInteger: cheaper when printing the table dominates
+	packed	 // IntegerTable: each row in one limb pool (no heap block per cell)
+};
+
+/** @class TableCheckpoint
+	@brief Where and how often a table job saves its frontier, and whether it resumes from it
+*/
+struct TableCheckpoint {
+	std::string path;		// checkpoint file ("": no checkpoints)
+	std::string output;		// file that the table is written to, synced to disk before each checkpoint ("": not synced)
+	double interval = 60;	// seconds between checkpoints
+	bool resume = false;	// continue from the checkpoint in path, if it belongs to the same job
+};
+
+void write_table(Table kind, int m, std::ostream& out, Representation representation = Representation::binary,
+	const TableCheckpoint& checkpoint = TableCheckpoint()); // Writes the m x m table using full precision
+void write_table_modular(Table kind, int m, std::ostream& out, unsigned threads = 0,
+	const TableCheckpoint& checkpoint = TableCheckpoint()); // Writes the m x m table using residues (0 threads: one per core)
+
+std::size_t table_bit_bound(Table kind, int m); // Bound on the number of bits of |T(k, n)| for 1 <= k, n <= m
+
+#endif //Ends the include guard
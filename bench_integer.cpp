@@ -0,0 +1,418 @@
+/** @file bench_integer.cpp
+	@brief Times the Integer operators over operand sizes, and the table generation of main.cpp
+
+Usage: bench_integer [options]
+	--max-bits N		largest operand size in bits (default 10000000); sizes double from one limb up to N
+	--min-time S		each measurement repeats the operation for at least S seconds (default 0.2)
+	--budget S			once one operation takes longer than S seconds, larger sizes of it are skipped (default 5)
+	--table-size M		size of the m x m tables and of the factorial list, which also scales the partitions (default 400)
+	--only PREFIX		only runs the benchmarks whose name starts with PREFIX (e.g. mul, table/)
+	--output FILE		writes the JSON report to FILE instead of standard output
+	--baseline FILE		compares against a report saved from an earlier run (see below)
+	--threshold P		a benchmark regresses when it is more than P percent slower than the baseline (default 10)
+
+The report is JSON with one result per line:
+	{"name": "mul", "size": 4096, "ns": 1234.5, "iterations": 1000}
+where size is the operand size in bits for the operators, m for the tables and factorials, and n for the partitions
+and the Stirling rows. With --baseline,
+each result also gets the baseline time and the ratio, the regressions are listed on standard error, and the
+exit status is 2 if there are any. Baselines are matched on (name, size), so the file must come from bench_integer.
+
+Operators: add, sub, mul (different operands), square, compare (equal up to the last limb), shl and shr
+(by a number of bits that is not a multiple of 64), and, or, xor, not, copy (a new Integer copied from another,
+which shares its limbs when INTEGER_COW is on), print (base 10) and parse (base 10).
+End to end: table/<kind>/<mode> writes the m x m table the way main.cpp does (mode binary, decimal, packed or modular);
+factorials writes 1!, ..., m!, each computed from the previous one.
+Partitions (Partition.h): partition/pentagonal computes p(0), ..., p(25m) by the pentagonal number recurrence and
+partition/hrr computes the single value p(2500m) (p(10^6) by default) by the Rademacher series.
+Stirling rows (StirlingRow.h): stirling/row1 and stirling/row2 compute s(., m) and S(., m) by product trees.
+Products switch to Karatsuba's method and to transforms at thresholds that can be set with INTEGER_KARATSUBA and
+INTEGER_NTT (see Integer.h), e.g. to find the best thresholds for a machine.
+*/
+
+#include "Integer.h"
+#include "IntegerKernels.h"
+#include "Partition.h"
+#include "StirlingRow.h"
+#include "Table.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/** @class Options
+	@brief The command line
+*/
+struct Options {
+	std::size_t max_bits = 10000000;
+	double min_time = 0.2;
+	double budget = 5;
+	int table_size = 400;
+	std::string only;
+	std::string output;
+	std::string baseline;
+	double threshold = 10;
+};
+
+/** @class Result
+	@brief One measurement
+*/
+struct Result {
+	std::string name;
+	std::size_t size;
+	double ns;				// time per operation
+	std::size_t iterations; // operations in the timed batch
+};
+
+/** @class CountingBuffer
+	@brief Stream buffer that discards its output (so the tables are timed without the disk)
+*/
+class CountingBuffer : public std::streambuf {
+public:
+	std::size_t bytes = 0;
+
+protected:
+	int_type overflow(int_type c) override {
+		++bytes;
+		return traits_type::not_eof(c);
+	}
+	std::streamsize xsputn(const char*, std::streamsize n) override {
+		bytes += (std::size_t)n;
+		return n;
+	}
+};
+
+volatile std::size_t sink; // keeps the results of the timed operations alive
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** Times op: runs it in batches lasting at least min_time and keeps the fastest of three batches
+	@param op operation being timed
+	@param min_time seconds per batch
+	@param result receives the time per operation and the batch size
+*/
+void time_op(const std::function<void()>& op, double min_time, Result& result) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	op(); // also warms up the caches and the scratch buffers
+	double once = seconds_since(start);
+	if (once >= min_time) { // too slow to repeat
+		result.ns = once * 1e9;
+		result.iterations = 1;
+		return;
+	}
+	std::size_t iterations = (std::size_t)(min_time / (once > 1e-9 ? once : 1e-9)) + 1;
+	double best = 0;
+	for (int batch = 0; batch < 3; ++batch) {
+		start = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < iterations; ++i) {
+			op();
+		}
+		double t = seconds_since(start) / iterations;
+		if (batch == 0 || t < best) {
+			best = t;
+		}
+	}
+	result.ns = best * 1e9;
+	result.iterations = iterations;
+}
+
+/** Returns a random Integer of exactly bits bits (the limbs are combined pairwise, so large operands are quick to make)
+*/
+Integer random_integer(std::mt19937_64& random, std::size_t bits) {
+	std::size_t limbs = (bits + 63) / 64;
+	std::vector<Integer> parts;
+	for (std::size_t i = 0; i < limbs; ++i) {
+		parts.push_back(Integer::from_limb(random()));
+	}
+	for (unsigned width = 64; parts.size() > 1; width *= 2) { // parts[i] holds width bits
+		std::vector<Integer> combined;
+		for (std::size_t i = 0; i < parts.size(); i += 2) {
+			combined.push_back(i + 1 < parts.size() ? (parts[i + 1] << width) | parts[i] : parts[i]);
+		}
+		parts.swap(combined);
+	}
+	Integer value = parts[0] >> (unsigned)(limbs * 64 - bits);
+	return value | (Integer(1) << (unsigned)(bits - 1));
+}
+
+/** Operand sizes: one limb, doubling up to max_bits (which is always included)
+*/
+std::vector<std::size_t> operand_sizes(std::size_t max_bits) {
+	std::vector<std::size_t> sizes;
+	for (std::size_t bits = 64; bits < max_bits; bits *= 2) {
+		sizes.push_back(bits);
+	}
+	sizes.push_back(max_bits);
+	return sizes;
+}
+
+bool selected(const Options& options, const std::string& name) {
+	return name.compare(0, options.only.size(), options.only) == 0;
+}
+
+/** Times the operators of Integer.h over the operand sizes
+*/
+void bench_operators(const Options& options, std::vector<Result>& results) {
+	// The operators work on a and b (both of the current size) into c; parse reads text, a decimal of the same size
+	Integer a, b, c;
+	std::string text;
+	const unsigned shift = 37;
+	const std::vector<std::pair<std::string, std::function<void()> > > operators = {
+		{ "add", [&] { c = a + b; sink = c.size(); } },
+		{ "sub", [&] { c = a - b; sink = c.size(); } },
+		{ "mul", [&] { c = a * b; sink = c.size(); } },
+		{ "square", [&] { c = a * a; sink = c.size(); } },
+		{ "compare", [&] { sink = (a < c) + (a == c); } }, // c == a except for the lowest bit
+		{ "shl", [&] { c = a << shift; sink = c.size(); } },
+		{ "shr", [&] { c = a >> shift; sink = c.size(); } },
+		{ "and", [&] { c = a & b; sink = c.size(); } },
+		{ "or", [&] { c = a | b; sink = c.size(); } },
+		{ "xor", [&] { c = a ^ b; sink = c.size(); } },
+		{ "not", [&] { c = ~a; sink = c.size(); } },
+		{ "copy", [&] { Integer copy(a); sink = copy.size(); } },
+		{ "print", [&] { std::ostringstream out; out << a; sink = out.str().size(); } },
+		{ "parse", [&] { std::istringstream in(text); in >> c; sink = c.size(); } }
+	};
+
+	std::mt19937_64 random(2017);
+	std::vector<std::size_t> sizes = operand_sizes(options.max_bits);
+	std::map<std::string, bool> over_budget;
+	for (std::size_t bits : sizes) {
+		a = random_integer(random, bits);
+		b = random_integer(random, bits);
+		text.assign((std::size_t)(bits * 0.30102999566398120) + 1, '0'); // a random number of about bits bits
+		for (std::size_t i = 0; i < text.size(); ++i) {
+			text[i] = (char)('0' + random() % 10);
+		}
+		text[0] = '1';
+		for (const std::pair<std::string, std::function<void()> >& op : operators) {
+			if (!selected(options, op.first) || over_budget[op.first]) {
+				continue;
+			}
+			if (op.first == "compare") {
+				c = a ^ Integer(1);
+			}
+			Result result = { op.first, bits, 0, 0 };
+			time_op(op.second, options.min_time, result);
+			results.push_back(result);
+			std::cerr << op.first << " " << bits << " bits: " << result.ns << " ns" << std::endl;
+			if (result.ns > options.budget * 1e9) {
+				over_budget[op.first] = true;
+				std::cerr << op.first << ": skipping sizes above " << bits << " bits (over the budget)" << std::endl;
+			}
+		}
+	}
+}
+
+/** Times the table generation and the factorials of main.cpp (written to a discarding stream)
+*/
+void bench_tables(const Options& options, std::vector<Result>& results) {
+	const std::pair<std::string, Table> kinds[] = {
+		{ "partition", Table::partition }, { "stirling1", Table::stirling1 }, { "stirling2", Table::stirling2 }
+	};
+	const int m = options.table_size;
+	for (const std::pair<std::string, Table>& kind : kinds) {
+		const std::pair<std::string, std::function<void(std::ostream&)> > modes[] = {
+			{ "binary", [&](std::ostream& out) { write_table(kind.second, m, out, Representation::binary); } },
+			{ "decimal", [&](std::ostream& out) { write_table(kind.second, m, out, Representation::decimal); } },
+			{ "packed", [&](std::ostream& out) { write_table(kind.second, m, out, Representation::packed); } },
+			{ "modular", [&](std::ostream& out) { write_table_modular(kind.second, m, out); } }
+		};
+		for (const std::pair<std::string, std::function<void(std::ostream&)> >& mode : modes) {
+			std::string name = "table/" + kind.first + "/" + mode.first;
+			if (!selected(options, name)) {
+				continue;
+			}
+			CountingBuffer buffer;
+			std::ostream out(&buffer);
+			Result result = { name, (std::size_t)m, 0, 0 };
+			time_op([&] { mode.second(out); }, options.min_time, result);
+			results.push_back(result);
+			std::cerr << name << " m = " << m << ": " << result.ns / 1e6 << " ms" << std::endl;
+		}
+	}
+
+	if (selected(options, "factorials")) {
+		CountingBuffer buffer;
+		std::ostream out(&buffer);
+		Result result = { "factorials", (std::size_t)m, 0, 0 };
+		time_op([&] {
+			Integer factorial = 1;
+			for (int n = 1; n <= m; ++n) {
+				factorial *= n;
+				out << factorial << "\n";
+			}
+		}, options.min_time, result);
+		results.push_back(result);
+		std::cerr << "factorials m = " << m << ": " << result.ns / 1e6 << " ms" << std::endl;
+	}
+}
+
+/** Times the partition numbers of Partition.h
+*/
+void bench_partitions(const Options& options, std::vector<Result>& results) {
+	if (selected(options, "partition/pentagonal")) {
+		const int N = 25 * options.table_size;
+		Result result = { "partition/pentagonal", (std::size_t)N, 0, 0 };
+		time_op([&] { partition_numbers(N); }, options.min_time, result);
+		results.push_back(result);
+		std::cerr << "partition/pentagonal n = " << N << ": " << result.ns / 1e6 << " ms" << std::endl;
+	}
+	if (selected(options, "partition/hrr")) {
+		const int n = 2500 * options.table_size;
+		Result result = { "partition/hrr", (std::size_t)n, 0, 0 };
+		time_op([&] { partition_number(n); }, options.min_time, result);
+		results.push_back(result);
+		std::cerr << "partition/hrr n = " << n << ": " << result.ns / 1e6 << " ms" << std::endl;
+	}
+}
+
+/** Times the Stirling rows of StirlingRow.h
+*/
+void bench_stirling_rows(const Options& options, std::vector<Result>& results) {
+	const std::pair<std::string, std::vector<Integer> (*)(int)> rows[] = {
+		{ "stirling/row1", stirling1_row }, { "stirling/row2", stirling2_row }
+	};
+	const int n = options.table_size;
+	for (const std::pair<std::string, std::vector<Integer> (*)(int)>& row : rows) {
+		if (!selected(options, row.first)) {
+			continue;
+		}
+		Result result = { row.first, (std::size_t)n, 0, 0 };
+		time_op([&] { row.second(n); }, options.min_time, result);
+		results.push_back(result);
+		std::cerr << row.first << " n = " << n << ": " << result.ns / 1e6 << " ms" << std::endl;
+	}
+}
+
+/** Reads a report written by bench_integer: (name, size) -> ns
+	@return false if the file cannot be read
+*/
+bool read_baseline(const std::string& path, std::map<std::pair<std::string, std::size_t>, double>& baseline) {
+	std::ifstream in(path);
+	if (!in) {
+		return false;
+	}
+	std::string line;
+	while (std::getline(in, line)) {
+		std::size_t name = line.find("\"name\": \""), size = line.find("\"size\": "), ns = line.find("\"ns\": ");
+		if (name == std::string::npos || size == std::string::npos || ns == std::string::npos) {
+			continue;
+		}
+		name += 9;
+		std::string key = line.substr(name, line.find('"', name) - name);
+		baseline[std::make_pair(key, (std::size_t)std::strtoull(line.c_str() + size + 8, nullptr, 10))] =
+			std::strtod(line.c_str() + ns + 6, nullptr);
+	}
+	return true;
+}
+
+/** Writes the JSON report, with the baseline comparison if there is one
+	@return number of regressions
+*/
+int write_report(std::ostream& out, const std::vector<Result>& results, const Options& options,
+	const std::map<std::pair<std::string, std::size_t>, double>& baseline) {
+	int regressions = 0;
+	out << "{\n";
+	out << "\t\"kernels\": \"" << limb_kernels().name << "\",\n";
+	out << "\t\"min_time\": " << options.min_time << ",\n";
+	if (!options.baseline.empty()) {
+		out << "\t\"baseline\": \"" << options.baseline << "\",\n";
+		out << "\t\"threshold\": " << options.threshold << ",\n";
+	}
+	out << "\t\"results\": [\n";
+	for (std::size_t i = 0; i < results.size(); ++i) {
+		const Result& r = results[i];
+		out << "\t\t{\"name\": \"" << r.name << "\", \"size\": " << r.size << ", \"ns\": " << r.ns
+			<< ", \"iterations\": " << r.iterations;
+		std::map<std::pair<std::string, std::size_t>, double>::const_iterator old = baseline.find(std::make_pair(r.name, r.size));
+		if (old != baseline.end() && old->second > 0) {
+			double ratio = r.ns / old->second;
+			bool regressed = ratio > 1 + options.threshold / 100;
+			out << ", \"baseline_ns\": " << old->second << ", \"ratio\": " << ratio
+				<< ", \"regression\": " << (regressed ? "true" : "false");
+			if (regressed) {
+				++regressions;
+				std::cerr << "REGRESSION " << r.name << " (" << r.size << "): " << old->second << " ns -> " << r.ns
+					<< " ns (" << (ratio - 1) * 100 << "% slower)" << std::endl;
+			}
+		}
+		out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "\t]\n";
+	out << "}\n";
+	return regressions;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		std::string option = argv[i];
+		bool has_value = i + 1 < argc;
+		if (option == "--max-bits" && has_value) {
+			options.max_bits = std::max<std::size_t>(64, std::strtoull(argv[++i], nullptr, 10));
+		}
+		else if (option == "--min-time" && has_value) {
+			options.min_time = std::strtod(argv[++i], nullptr);
+		}
+		else if (option == "--budget" && has_value) {
+			options.budget = std::strtod(argv[++i], nullptr);
+		}
+		else if (option == "--table-size" && has_value) {
+			options.table_size = std::atoi(argv[++i]);
+		}
+		else if (option == "--only" && has_value) {
+			options.only = argv[++i];
+		}
+		else if (option == "--output" && has_value) {
+			options.output = argv[++i];
+		}
+		else if (option == "--baseline" && has_value) {
+			options.baseline = argv[++i];
+		}
+		else if (option == "--threshold" && has_value) {
+			options.threshold = std::strtod(argv[++i], nullptr);
+		}
+		else {
+			std::cerr << "Usage: " << argv[0] << " [--max-bits N] [--min-time S] [--budget S] [--table-size M]"
+				<< " [--only PREFIX] [--output FILE] [--baseline FILE] [--threshold P]" << std::endl;
+			return 1;
+		}
+	}
+
+	std::map<std::pair<std::string, std::size_t>, double> baseline;
+	if (!options.baseline.empty() && !read_baseline(options.baseline, baseline)) {
+		std::cerr << "Cannot read the baseline " << options.baseline << std::endl;
+		return 1;
+	}
+
+	std::vector<Result> results;
+	bench_operators(options, results);
+	bench_tables(options, results);
+	bench_partitions(options, results);
+	bench_stirling_rows(options, results);
+
+	int regressions;
+	if (options.output.empty()) {
+		regressions = write_report(std::cout, results, options, baseline);
+	}
+	else {
+		std::ofstream out(options.output);
+		regressions = write_report(out, results, options, baseline);
+	}
+	return regressions > 0 ? 2 : 0;
+}
@@ -8,12 +8,27 @@ Partition:						p(k, n) = p(k, n-k) + p(k-1, n)				1 <= k <= n
 Stirling numbers (1st kind):	s(k, n) = -(n-1) s(k, n-1) + s(k-1, n-1)	1 <= k <= n
 Stirling numbers (2nd kind):	S(k, n) = kS(k, n-1) + S(k-1, n-1)			1 <= k <= n
 Factorial:						n! = n*(n-1)!
+
+The tables are generated row by row from these recurrences (see Table.h); the recursive functions below
+compute single entries. With --cell they are memoized in caches shared by one thread per requested entry
+(see IntegerCache.h). Their recurrences are written in their natural form; with expression templates
+switched on below, each right-hand side is evaluated in one pass with fused multiply-adds (see IntegerExpr.h).
 */
 
+#define INTEGER_EXPRESSION_TEMPLATES
+
 #include <iostream>
 #include <fstream>
 #include "Integer.h"
+#include "IntegerCache.h"
+#include "Partition.h"
+#include "StirlingRow.h"
+#include "Table.h"
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <functional>
+#include <thread>
 #include <vector>
 #include <string>
 
@@ -23,7 +38,120 @@ Integer s(Integer k, Integer n); // Stirling #1
 Integer S(Integer k, Integer n); // Stirling #2
 Integer operator!(Integer n);	 // Factorial
 
-int main() {
+// Memos of the recursive functions while --cell runs (null: not memoized)
+IntegerCache* partition_cache = nullptr;
+IntegerCache* stirling1_cache = nullptr;
+IntegerCache* stirling2_cache = nullptr;
+Integer memoized(IntegerCache* cache, const Integer& k, const Integer& n, const std::function<Integer()>& compute);
+
+/** @class Cell
+	@brief One entry requested with --cell
+*/
+struct Cell {
+	char function; // 'p', 's' or 'S'
+	int k;
+	int n;
+};
+
+bool compute_cells(const std::vector<Cell>& cells, std::size_t budget); // Prints each cell (one thread per cell)
+Integer evaluate(char function, int k, int n); // p(k, n), s(k, n) or S(k, n)
+Integer fill(const Cell& cell); // Computes a cell bottom-up, row by row, through the memo of its function
+bool is_memoized(const Cell& cell); // Whether the recursive function memoizes cell (it is not a base case)
+int memoized_operands(const Cell& cell, Cell operands[2]); // The memoized cells that the recurrence of cell reads
+void row_range(const Cell& cell, int j, int& first, int& last); // Row j of the cells filled below cell
+std::size_t fill_memory(const Cell& cell); // Bytes of the rows that fill keeps at once
+double cell_bits(char function, int k, int n); // Upper bound on the bits of p(k, n), s(k, n) or S(k, n)
+
+/** @class TableOptions
+	@brief How the tables are generated (from the command line)
+*/
+struct TableOptions {
+	bool modular = false;										// multi-modular mode
+	unsigned threads = 0;										// worker threads for the multi-modular mode (0: one per core)
+	Representation representation = Representation::binary;	// number type for the full-precision mode
+	bool checkpoint = false;									// saves <file>.checkpoint while a table is written
+	double interval = 60;										// seconds between checkpoints
+	bool resume = false;										// continues from the checkpoints
+};
+
+void create_table(Table kind, int m, const std::string& file, const TableOptions& options); // Writes one table
+void truncate_file(const std::string& file, std::streamoff size); // Keeps the first size bytes of file
+
+/** Usage: main [--modular] [--threads N] [--decimal | --packed] [--checkpoint] [--interval S] [--resume]
+	   or: main --partition N | --stirling1 N | --stirling2 N
+	   or: main --cell F K N [--cell F K N ...] [--cache MB]
+	--modular		computes the tables modulo 62-bit primes and reconstructs each entry (see Table.h)
+	--threads N		number of worker threads for --modular (default: one per core)
+	--decimal		computes the tables with base 10^19 limbs, so that printing does not divide (see DecimalInteger.h)
+	--packed		stores each row of a table in one limb pool (see IntegerTable.h)
+	--checkpoint	saves the progress of each table in <table file>.checkpoint (e.g. Partition.txt.checkpoint)
+	--interval S	seconds between checkpoints (default 60)
+	--resume		continues each table from its checkpoint (run with the same size and options as before)
+	--partition N	prints the partition number p(N) and exits (Hardy-Ramanujan-Rademacher series; see Partition.h)
+	--stirling1 N	prints s(0, N), ..., s(N, N) on one line and exits (product tree; see StirlingRow.h)
+	--stirling2 N	prints S(0, N), ..., S(N, N) on one line and exits
+	--cell F K N	prints F(K, N) for F = p, s or S with the memoized recursive functions, and exits; the cells
+					given are computed at the same time, one thread each, sharing their sub-results
+	--cache MB		memory budget of --cell, in megabytes (default 1024): the rows that each cell is computed
+					from bottom-up, and the memos; a budget less than twice the rows is rejected
+*/
+int main(int argc, char* argv[]) {
+	TableOptions options;
+	std::vector<Cell> cells;
+	std::size_t cache_megabytes = 1024;
+	for (int i = 1; i < argc; ++i) {
+		std::string option = argv[i];
+		if (option == "--modular") {
+			options.modular = true;
+		}
+		else if (option == "--threads" && i + 1 < argc) {
+			options.threads = (unsigned)std::stoul(argv[++i]);
+		}
+		else if (option == "--decimal") {
+			options.representation = Representation::decimal;
+		}
+		else if (option == "--packed") {
+			options.representation = Representation::packed;
+		}
+		else if (option == "--checkpoint") {
+			options.checkpoint = true;
+		}
+		else if (option == "--interval" && i + 1 < argc) {
+			options.interval = std::stod(argv[++i]);
+		}
+		else if (option == "--resume") {
+			options.checkpoint = true;
+			options.resume = true;
+		}
+		else if (option == "--partition" && i + 1 < argc) {
+			std::cout << partition_number(std::stoi(argv[++i])) << std::endl;
+			return 0;
+		}
+		else if ((option == "--stirling1" || option == "--stirling2") && i + 1 < argc) {
+			int n = std::stoi(argv[++i]);
+			for (const Integer& value : option == "--stirling1" ? stirling1_row(n) : stirling2_row(n)) {
+				std::cout << value << " ";
+			}
+			std::cout << std::endl;
+			return 0;
+		}
+		else if (option == "--cell" && i + 3 < argc && std::string("psS").find(argv[i + 1][0]) != std::string::npos) {
+			Cell cell = { argv[i + 1][0], std::stoi(argv[i + 2]), std::stoi(argv[i + 3]) };
+			cells.push_back(cell);
+			i += 3;
+		}
+		else if (option == "--cache" && i + 1 < argc) {
+			cache_megabytes = (std::size_t)std::stoull(argv[++i]);
+		}
+		else {
+			std::cerr << "Usage: " << argv[0] << " [--modular] [--threads N] [--decimal | --packed] [--checkpoint] [--interval S] [--resume]"
+				<< " | --partition N | --stirling1 N | --stirling2 N | --cell F K N [--cell F K N ...] [--cache MB]" << std::endl;
+			return 1;
+		}
+	}
+	if (!cells.empty()) {
+		return compute_cells(cells, cache_megabytes << 20) ? 0 : 1;
+	}
 
     // First, let's show off that the Integer class can hold more digits than an int variable
     Integer a = __INT_MAX__;
@@ -39,56 +167,19 @@ int main() {
 	std::cin >> m;
 
 	// 1. Partition
-	// Open file for writing
-	std::ofstream outputData1("Partition.txt");
 	std::cout << "Creating Partition.txt file ... ";
-
-	for (size_t i = 1; i <= m; ++i) { // Generate ith entry (row)
-		for (size_t j = 1; j <= m; ++j) { // Generate jth entry (column)
-			Integer k = i;
-			Integer n = j;
-			outputData1 << p(k, n) << " ";
-		}
-		outputData1 << std::endl; // Go to next row (enter)
-	}
-
-
+	create_table(Table::partition, m, "Partition.txt", options);
 	std::cout << "Done." << std::endl;
-	outputData1.close();
 
 	// 2. Stirling -- first kind
-	// Open file for writing
-	std::ofstream outputData2("Stirling1.txt");
 	std::cout << "Creating Stirling1.txt file ... ";
-
-	for (size_t i = 1; i <= m; ++i) { // Generate ith entry (row)
-		for (size_t j = 1; j <= m; ++j) { // Generate jth entry (column)
-			Integer k = i;
-			Integer n = j;
-			outputData2 << s(k, n) << " ";
-		}
-		outputData2 << std::endl; // Go to next row (enter)
-	}
-
+	create_table(Table::stirling1, m, "Stirling1.txt", options);
 	std::cout << "Done." << std::endl;
-	outputData2.close();
 
 	// 3. Stirling -- second kind
-	// Open file for writing
-	std::ofstream outputData3("Stirling2.txt");
 	std::cout << "Creating Stirling2.txt file ... ";
-
-	for (size_t i = 1; i <= m; ++i) { // Generate ith entry (row)
-		for (size_t j = 1; j <= m; ++j) { // Generate jth entry (column)
-			Integer k = i;
-			Integer n = j;
-			outputData3 << S(k, n) << " ";
-		}
-		outputData3 << std::endl; // Go to next row (enter)
-	}
-
+	create_table(Table::stirling2, m, "Stirling2.txt", options);
 	std::cout << "Done." << std::endl;
-	outputData3.close();
 
 	// 4. Factorial
 	// Open file for writing
@@ -108,6 +199,293 @@ int main() {
 	return 0;
 }
 
+/** Writes the m x m table of kind to file
+	@param kind table
+	@param m number of rows and columns
+	@param file name of the file being written (e.g. Partition.txt)
+	@param options mode, threads, representation and checkpoints
+*/
+void create_table(Table kind, int m, const std::string& file, const TableOptions& options) {
+	TableCheckpoint checkpoint;
+	if (options.checkpoint) {
+		checkpoint.path = file + ".checkpoint";
+		checkpoint.output = file;
+		checkpoint.interval = options.interval;
+		checkpoint.resume = options.resume;
+	}
+
+	// Open file for writing (a resumed table keeps what was written before the checkpoint)
+	std::fstream out;
+	if (options.resume) {
+		out.open(file, std::ios::in | std::ios::out);
+	}
+	if (!out.is_open()) {
+		out.open(file, std::ios::out | std::ios::trunc);
+	}
+
+	if (options.modular) {
+		write_table_modular(kind, m, out, options.threads, checkpoint);
+	}
+	else {
+		write_table(kind, m, out, options.representation, checkpoint);
+	}
+	std::streamoff end = out.tellp();
+	out.close();
+	if (options.resume) { // a file from another job (that the checkpoint did not match) may have been longer
+		truncate_file(file, end);
+	}
+}
+
+/** Shortens file to its first size bytes (if it is longer), by copying them to a new file
+	@param file name of the file
+	@param size number of bytes to keep
+*/
+void truncate_file(const std::string& file, std::streamoff size) {
+	std::ifstream in(file, std::ios::binary | std::ios::ate);
+	if (!in || size < 0 || (std::streamoff)in.tellg() <= size) {
+		return;
+	}
+	in.seekg(0);
+	std::string copy = file + ".tmp";
+	{
+		std::ofstream out(copy, std::ios::binary | std::ios::trunc);
+		std::vector<char> buffer(1 << 20);
+		for (std::streamoff left = size; left > 0; ) {
+			std::streamsize chunk = (std::streamsize)std::min<std::streamoff>(left, (std::streamoff)buffer.size());
+			in.read(buffer.data(), chunk);
+			out.write(buffer.data(), chunk);
+			left -= chunk;
+		}
+	}
+	in.close();
+	std::remove(file.c_str());
+	std::rename(copy.c_str(), file.c_str());
+}
+
+/** Computes the requested cells with the memoized recursive functions, one thread per cell, and prints them
+	in the order given (e.g. "S(5000, 12000) = ...")
+	@param cells the cells
+	@param budget bytes for the rows kept by the threads (see fill) and the memos together
+	@return false (having printed nothing but an error) if the budget cannot hold the rows
+*/
+bool compute_cells(const std::vector<Cell>& cells, std::size_t budget) {
+	// What the rows do not take is shared by the memos of the functions asked for, which need at least as much
+	// (a memo that holds a few values per shard may evict an operand that was just stored back)
+	const std::string functions = "psS";
+	std::size_t rows = 0, used = 0;
+	bool asked[3] = { false, false, false };
+	for (const Cell& cell : cells) {
+		rows += fill_memory(cell);
+		bool& function = asked[functions.find(cell.function)];
+		used += !function;
+		function = true;
+	}
+	if (2 * rows > budget) {
+		std::cerr << "--cache " << (budget >> 20) << " is too small for these cells: the rows they are computed from take "
+			<< (rows >> 20) + 1 << " MB, and the memos need as much again (use at least --cache " << ((2 * rows) >> 20) + 1
+			<< ")" << std::endl;
+		return false;
+	}
+	std::size_t share = (budget - rows) / std::max<std::size_t>(used, 1);
+
+	IntegerCache partition_memo(share), stirling1_memo(share), stirling2_memo(share);
+	partition_cache = &partition_memo;
+	stirling1_cache = &stirling1_memo;
+	stirling2_cache = &stirling2_memo;
+
+	std::vector<Integer> values(cells.size());
+	std::vector<std::thread> threads;
+	for (std::size_t i = 0; i < cells.size(); ++i) {
+		threads.emplace_back([&cells, &values, i] {
+			values[i] = fill(cells[i]);
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	for (std::size_t i = 0; i < cells.size(); ++i) {
+		std::cout << cells[i].function << "(" << cells[i].k << ", " << cells[i].n << ") = " << values[i] << std::endl;
+	}
+
+	for (IntegerCache* cache : { partition_cache, stirling1_cache, stirling2_cache }) {
+		IntegerCache::Statistics statistics = cache->statistics();
+		if (statistics.misses != 0) {
+			std::cerr << (cache == partition_cache ? "p" : cache == stirling1_cache ? "s" : "S") << " memo: "
+				<< statistics.misses << " computed, " << statistics.hits << " hits, " << statistics.waits << " waits, "
+				<< statistics.evictions << " evicted, " << cache->memory() / 1e6 << " MB" << std::endl;
+		}
+	}
+	partition_cache = stirling1_cache = stirling2_cache = nullptr;
+	return true;
+}
+
+/** Computes a cell bottom-up: the memoized cells below it are evaluated row j = 1, 2, ... in order of n (see
+	row_range), each once both cells that its recurrence reads (in row j before n, and in row j - 1 or, for p,
+	on the diagonal) are in the memo. The fill keeps rows j - 1 and j, and the diagonal p(j, j), and stores
+	back those of them that the memo has evicted, so no recursion goes more than one call deep and no cell is
+	computed twice, whatever the budget of the memo (evaluating the cell directly could go n calls deep, and
+	overflow the stack of the thread)
+	@param cell the requested cell
+	@return its value
+*/
+Integer fill(const Cell& cell) {
+	IntegerCache* cache = cell.function == 'p' ? partition_cache : cell.function == 's' ? stirling1_cache : stirling2_cache;
+	std::vector<Integer> previous, current, diagonal(1); // rows j - 1 and j, and p(j, j) for j >= 1
+	int previous_first = 0;
+	for (int j = 1; j <= std::min(cell.k, cell.n); ++j) {
+		int first, last;
+		row_range(cell, j, first, last);
+		current.clear();
+		for (int m = first; m <= last; ++m) {
+			Cell here = { cell.function, j, m }, operands[2];
+			int count = memoized_operands(here, operands);
+			for (bool stored = true; stored; ) { // (storing one operand may evict the other)
+				stored = false;
+				for (int i = 0; i < count; ++i) {
+					const Cell& operand = operands[i];
+					if (!cache->contains(operand.k, operand.n)) { // evicted
+						cache->put(operand.k, operand.n, operand.k == j ? current[operand.n - first]
+							: operand.k == j - 1 ? previous[operand.n - previous_first] : diagonal[operand.k]);
+						stored = true;
+					}
+				}
+			}
+			current.push_back(evaluate(cell.function, j, m));
+		}
+		if (cell.function == 'p') {
+			diagonal.push_back(current.front());
+		}
+		previous.swap(current);
+		previous_first = first;
+	}
+	return previous.empty() ? evaluate(cell.function, cell.k, cell.n) : previous.back(); // (a base case if empty)
+}
+
+/** Tells whether the recursive function of cell memoizes it, i.e. it is not a base case: p(k, n) for
+	1 <= k <= n, and s(k, n) or S(k, n) for 1 <= k < n
+	@param cell the cell
+	@return true if the cell is memoized
+*/
+bool is_memoized(const Cell& cell) {
+	return cell.k >= 1 && (cell.function == 'p' ? cell.k <= cell.n : cell.k < cell.n);
+}
+
+/** Gives the cells that the recurrence of a memoized cell reads and that are memoized themselves: among
+	p(k, n - k) and p(k - 1, n) (p(j, m) being read as p(m, m) for j > m), or F(k, n - 1) and F(k - 1, n - 1)
+	for s and S
+	@param cell a memoized cell
+	@param operands receives the cells
+	@return number of cells given (0, 1 or 2)
+*/
+int memoized_operands(const Cell& cell, Cell operands[2]) {
+	Cell reads[2] = { { cell.function, cell.k, cell.n - 1 }, { cell.function, cell.k - 1, cell.n - 1 } };
+	if (cell.function == 'p') {
+		reads[0].n = cell.n - cell.k;
+		reads[1].n = cell.n;
+	}
+	int count = 0;
+	for (Cell& read : reads) {
+		if (read.function == 'p' && read.k > read.n) {
+			read.k = read.n;
+		}
+		if (is_memoized(read)) {
+			operands[count++] = read;
+		}
+	}
+	return count;
+}
+
+/** Gives row j of the cells that compute_cells evaluates below cell: F(j, m) for first <= m <= last, which are
+	p(j, m) for j <= m <= n (below the diagonal p(j, m) is p(m, m)), and s(j, m) or S(j, m) for m - j from 1 to
+	n - k (their recurrences never raise n - k, and m = j is 1)
+	@param cell the requested cell
+	@param j row, from 1 to min(k, n)
+	@param first receives the first m
+	@param last receives the last m (less than first if the row is empty)
+*/
+void row_range(const Cell& cell, int j, int& first, int& last) {
+	if (cell.function == 'p') {
+		first = j;
+		last = cell.n;
+	}
+	else {
+		first = j + 1;
+		last = j + cell.n - cell.k;
+	}
+}
+
+/** Bounds the memory of the rows that fill keeps at once for cell: the largest two rows (sampled, from
+	cell_bits), and for p the diagonal p(j, j)
+	@param cell the requested cell
+	@return bytes
+*/
+std::size_t fill_memory(const Cell& cell) {
+	auto bytes = [&cell](int k, int n) { // of function(k, n)
+		return (double)(sizeof(Integer) + ((std::size_t)(cell_bits(cell.function, k, n) / 64) + 1) * sizeof(Integer::limb));
+	};
+	int rows = std::min(cell.k, cell.n);
+	double largest = 0, diagonal = 0;
+	for (int j = 1; j <= rows; j = (j < rows) ? std::min(j + std::max(rows / 64, 1), rows) : rows + 1) {
+		int first, last;
+		row_range(cell, j, first, last);
+		int step = std::max((last - first + 1) / 256, 1);
+		double row = 0;
+		for (int m = first; m <= last; m += step) { // each sample stands for step cells, at its largest
+			row += std::min(step, last - m + 1) * bytes(j, std::min(m + step - 1, last));
+		}
+		largest = std::max(largest, row);
+	}
+	if (cell.function == 'p') {
+		for (int j = 1; j <= rows; ++j) {
+			diagonal += bytes(j, j);
+		}
+	}
+	return (std::size_t)(2 * largest + diagonal);
+}
+
+/** Bounds the size of a cell from above, for 1 <= k <= n: p(k, n) <= p(n) < e^(pi sqrt(2n/3)),
+	|s(k, n)| <= C(n - 1, k - 1) (n - 1)!/(k - 1)! (a sum of that many products of n - k of the numbers 1 to n - 1)
+	and S(k, n) <= C(n, k) k^(n - k)
+	@param function 'p', 's' or 'S'
+	@param k first input
+	@param n second input
+	@return bits
+*/
+double cell_bits(char function, int k, int n) {
+	const double pi = 3.14159265358979323846;
+	double natural = function == 'p' ? pi * std::sqrt(2.0 * n / 3)
+		: function == 's' ? 2 * std::lgamma((double)n) - 2 * std::lgamma((double)k) - std::lgamma(n - k + 1.0)
+		: std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0) + (n - k) * std::log((double)k);
+	return natural / std::log(2.0) + 1;
+}
+
+/** Computes one cell with the recursive functions
+	@param function 'p', 's' or 'S'
+	@param k first input
+	@param n second input
+	@return function(k, n)
+*/
+Integer evaluate(char function, int k, int n) {
+	return function == 'p' ? p(k, n) : function == 's' ? s(k, n) : S(k, n);
+}
+
+/** Returns f(k, n) from cache, computing it (and caching it) if it is not there
+	@param cache memo of f, or nullptr to compute without one
+	@param k first input
+	@param n second input
+	@param compute computes f(k, n) (by the recurrence)
+	@return f(k, n)
+*/
+Integer memoized(IntegerCache* cache, const Integer& k, const Integer& n, const std::function<Integer()>& compute) {
+	const Integer::limb largest = __INT_MAX__;
+	if (cache == nullptr || k.size() > 1 || n.size() > 1 || (k.size() == 1 && k.limbs()[0] > largest)
+		|| (n.size() == 1 && n.limbs()[0] > largest)) { // the memo is keyed on ints
+		return compute();
+	}
+	int key_k = k.size() ? (int)k.limbs()[0] : 0, key_n = n.size() ? (int)n.limbs()[0] : 0;
+	return cache->get(k.negative() ? -key_k : key_k, n.negative() ? -key_n : key_n, compute);
+}
+
 /** Computes p(k,n)
 	@param k first input
 	@param n second input
@@ -128,7 +506,7 @@ Integer p(Integer k, Integer n) {
 		return p(n, n);
 	}
 	else { // inductive step: p(k, n) = p(k, n-k) + p(k-1, n)
-		return p(k, n - k) + p(k - 1, n);
+		return memoized(partition_cache, k, n, [&]() -> Integer { return p(k, n - k) + p(k - 1, n); });
 	}
 	
 }
@@ -155,7 +533,7 @@ Integer s(Integer k, Integer n) {
 		return 1;
 	}
 	else { // inductive step: s(k, n) = -(n - 1)*s(k, n - 1) + s(k - 1, n - 1)
-		return -((n - 1)*s(k, n - 1)) + s(k - 1, n - 1);
+		return memoized(stirling1_cache, k, n, [&]() -> Integer { return -((n - 1)*s(k, n - 1)) + s(k - 1, n - 1); });
 	}
 }
 
@@ -181,7 +559,7 @@ Integer S(Integer k, Integer n) {
 		return 1;
 	}
 	else { // inductive step: k*S(k, n - 1) + S(k - 1, n - 1)
-		return k*S(k, n - 1) + S(k - 1, n - 1);
+		return memoized(stirling2_cache, k, n, [&]() -> Integer { return k*S(k, n - 1) + S(k - 1, n - 1); });
 	}
 }
 
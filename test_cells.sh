@@ -0,0 +1,24 @@
+#!/bin/sh
+# Regression run of tables --cell (run by ctest as "sh test_cells.sh <tables>"): two cells whose memos evict
+# most of what they compute, on a 256 KB stack. Checks their values against --partition and --stirling2, and
+# that no cell was computed twice (p(1000, 1000) has 500500 memoized cells below it, S(200, 900) 140000).
+
+tables="$1"
+ulimit -s 256 || exit 1
+"$tables" --cell p 1000 1000 --cell S 200 900 --cache 2 > cells.out 2> cells.err || { cat cells.err; exit 1; }
+status=0
+
+expected="p(1000, 1000) = $("$tables" --partition 1000)"
+actual=$(sed -n 1p cells.out)
+[ "$actual" = "$expected" ] || { echo "FAILED: $actual, expected $expected"; status=1; }
+
+expected="S(200, 900) = $("$tables" --stirling2 900 | cut -d ' ' -f 201)"
+actual=$(sed -n 2p cells.out)
+[ "$actual" = "$expected" ] || { echo "FAILED: $actual, expected $expected"; status=1; }
+
+grep -q "^p memo: 500500 computed, .* [1-9][0-9]* evicted" cells.err || { echo "FAILED: p memo"; cat cells.err; status=1; }
+grep -q "^S memo: 140000 computed, .* [1-9][0-9]* evicted" cells.err || { echo "FAILED: S memo"; cat cells.err; status=1; }
+
+rm -f cells.out cells.err
+[ $status -eq 0 ] && echo "All checks passed"
+exit $status
@@ -0,0 +1,49 @@
+#!/bin/sh
+# Regression run of tables --checkpoint and --resume (run by ctest as "sh test_checkpoint.sh <tables>"): each
+# mode is killed (SIGKILL) in the middle of the Stirling1 table, just after its first checkpoint, and resumed;
+# the four files must then be identical to those of an uninterrupted run. Runs in checkpoint_test/. (The
+# multi-modular mode saves after each block of rows, so its table is large enough to have several blocks.)
+
+tables="$1"
+mkdir -p checkpoint_test && cd checkpoint_test || exit 1
+status=0
+
+# check <size> <options>: reference run in reference/, killed and resumed run in resumed/
+check() {
+	mode="${2:-the full-precision mode}"
+	rm -rf reference resumed
+	mkdir reference resumed
+	echo "$1" > size
+	(cd reference && "$tables" $2 < ../size > /dev/null) || { echo "FAILED: reference run of $mode"; status=1; return; }
+
+	cd resumed
+	"$tables" $2 --checkpoint --interval 0.05 < ../size > /dev/null 2> killed.err &
+	pid=$!
+	while kill -0 $pid 2> /dev/null && [ ! -e Stirling1.txt.checkpoint ]; do
+		sleep 0.01
+	done
+	kill -9 $pid 2> /dev/null
+	wait $pid 2> /dev/null
+	cd ..
+	if [ ! -e resumed/Stirling1.txt.checkpoint ] || [ -e resumed/Stirling2.txt ]; then
+		echo "FAILED: $mode was not killed in the middle of Stirling1.txt"
+		status=1
+		return
+	fi
+
+	(cd resumed && "$tables" $2 --resume --interval 0.05 < ../size > /dev/null 2> resumed.err) || { echo "FAILED: resumed run of $mode"; cat resumed/resumed.err; status=1; return; }
+	for file in Partition Stirling1 Stirling2 Factorials; do
+		cmp -s reference/$file.txt resumed/$file.txt || { echo "FAILED: $file.txt of the resumed run of $mode differs"; status=1; }
+	done
+	if grep -v "^No checkpoint Stirling2.txt.checkpoint" resumed/resumed.err; then # only Stirling2 starts afresh
+		echo "FAILED: $mode did not resume from its checkpoints"
+		status=1
+	fi
+}
+
+check 600 ""
+check 600 "--modular"
+
+cd .. && rm -rf checkpoint_test
+[ $status -eq 0 ] && echo "All checks passed"
+exit $status
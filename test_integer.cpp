@@ -0,0 +1,516 @@
+/** @file test_integer.cpp
+	@brief Regression checks for Integer (run by ctest)
+
+Each check compares the result of an operation against the same value computed another way, and prints the
+checks that fail. The exit status is 1 if any check fails.
+*/
+
+#include "DecimalInteger.h"
+#include "Integer.h"
+#include "IntegerKernels.h"
+#include "Partition.h"
+#include "StirlingRow.h"
+#include <climits>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+/** Records one check
+	@param passed result of the check
+	@param name what was checked (printed if it failed)
+*/
+void check(bool passed, const std::string& name) {
+	if (!passed) {
+		std::cerr << "FAILED: " << name << std::endl;
+		++failures;
+	}
+}
+
+/** Fused multiply-adds whose accumulator is also an operand
+*/
+void test_aliasing() {
+	const int values[] = { 5, -5, 7, -7, 0 };
+	for (int a : values) {
+		for (int b : values) {
+			Integer x = a, y = b, expected;
+
+			expected = Integer(a) - Integer(a) * Integer(b);
+			Integer acc = x;
+			submul(acc, acc, y);
+			check(acc == expected, "submul(a, a, b) for a = " + std::to_string(a) + ", b = " + std::to_string(b));
+			acc = x;
+			submul(acc, y, acc);
+			check(acc == expected, "submul(a, b, a) for a = " + std::to_string(a) + ", b = " + std::to_string(b));
+
+			expected = Integer(a) + Integer(a) * Integer(b);
+			acc = x;
+			addmul(acc, acc, y);
+			check(acc == expected, "addmul(a, a, b) for a = " + std::to_string(a) + ", b = " + std::to_string(b));
+		}
+		Integer acc = a;
+		submul(acc, acc, acc);
+		check(acc == Integer(a) - Integer(a) * Integer(a), "submul(a, a, a) for a = " + std::to_string(a));
+	}
+
+	// Operands long enough for Karatsuba's method (a product formed apart from acc)
+	Integer big = 3;
+	for (int i = 0; i < 11; ++i) {
+		big *= big; // 3^2048, 51 limbs
+	}
+	Integer acc = big, expected = big - big * big;
+	submul(acc, acc, acc);
+	check(acc == expected, "submul(a, a, a) for a = 3^2048");
+	acc = -big;
+	expected = -big + big * big;
+	submul(acc, big, acc);
+	check(acc == expected, "submul(a, b, a) for a = -3^2048, b = 3^2048");
+
+	for (int a : values) {
+		for (int b : { 0, 3, 1 << 30 }) {
+			Integer expected = Integer(a) - Integer(a) * Integer(b);
+			Integer acc = a;
+			submul_limb(acc, acc, (Integer::limb)b);
+			check(acc == expected, "submul_limb(a, a, b) for a = " + std::to_string(a) + ", b = " + std::to_string(b));
+			expected = Integer(a) + Integer(a) * Integer(b);
+			acc = a;
+			addmul_limb(acc, acc, (Integer::limb)b);
+			check(acc == expected, "addmul_limb(a, a, b) for a = " + std::to_string(a) + ", b = " + std::to_string(b));
+		}
+	}
+}
+
+/** addmul_limb, submul_limb and mul_limb against the operators, over operand lengths and signs (this covers the in-place
+	subtraction of a product that is larger or smaller than the accumulator)
+*/
+void test_mul_limb() {
+	std::mt19937_64 random(26);
+	for (int trial = 0; trial < 2000; ++trial) {
+		Integer acc = 0, x = 0;
+		for (int i = random() % 5; i > 0; --i) {
+			acc <<= 64;
+			acc += (int)(random() % 3 == 0 ? 0 : random() >> 33);
+		}
+		for (int i = random() % 5; i > 0; --i) {
+			x <<= 64;
+			x += (int)(random() >> 33);
+		}
+		if (random() % 2) {
+			acc = -acc;
+		}
+		if (random() % 2) {
+			x = -x;
+		}
+		Integer::limb y = random() % 4 == 0 ? ~(Integer::limb)0 : random();
+		Integer y_value = 0;
+		for (int shift = 48; shift >= 0; shift -= 16) {
+			y_value <<= 16;
+			y_value += (int)(y >> shift & 0xffff);
+		}
+
+		Integer result = acc;
+		addmul_limb(result, x, y);
+		check(result == acc + x * y_value, "addmul_limb, trial " + std::to_string(trial));
+		result = acc;
+		submul_limb(result, x, y);
+		check(result == acc - x * y_value, "submul_limb, trial " + std::to_string(trial));
+		result = x;
+		result.mul_limb(y);
+		check(result == x * y_value, "mul_limb, trial " + std::to_string(trial));
+	}
+}
+
+/** DecimalInteger's sums, differences and fused multiply-adds (including an accumulator that is also the
+	operand), against Integer
+*/
+void test_decimal() {
+	std::mt19937_64 random(30);
+	for (int trial = 0; trial < 1000; ++trial) {
+		Integer a = 0, b = 0;
+		for (int i = random() % 4; i > 0; --i) {
+			a <<= 64;
+			a += (int)(random() >> 33);
+		}
+		for (int i = random() % 4; i > 0; --i) {
+			b <<= 64;
+			b += (int)(random() >> 33);
+		}
+		a = random() % 2 ? -a : a;
+		b = random() % 2 ? -b : b;
+		check((DecimalInteger(a) + DecimalInteger(b)).to_integer() == a + b, "DecimalInteger a + b, trial " + std::to_string(trial));
+		check((DecimalInteger(a) - DecimalInteger(b)).to_integer() == a - b, "DecimalInteger a - b, trial " + std::to_string(trial));
+	}
+
+	const int values[] = { 5, -5, 7, -7, 0 };
+	for (int a : values) {
+		for (int b : { 0, 3, 1 << 30 }) {
+			Integer expected = Integer(a) - Integer(a) * Integer(b);
+			DecimalInteger acc = a;
+			submul_limb(acc, acc, (DecimalInteger::limb)b);
+			check(acc.to_integer() == expected, "DecimalInteger submul_limb(a, a, b) for a = " + std::to_string(a) + ", b = " + std::to_string(b));
+			acc = a;
+			submul_limb(acc, DecimalInteger(b), (DecimalInteger::limb)b);
+			check(acc.to_integer() == Integer(a) - Integer(b) * Integer(b), "DecimalInteger submul_limb(a, b, b) for a = " + std::to_string(a) + ", b = " + std::to_string(b));
+			expected = Integer(a) + Integer(a) * Integer(b);
+			acc = a;
+			addmul_limb(acc, acc, (DecimalInteger::limb)b);
+			check(acc.to_integer() == expected, "DecimalInteger addmul_limb(a, a, b) for a = " + std::to_string(a) + ", b = " + std::to_string(b));
+		}
+	}
+}
+
+/** Every kernel variant that this CPU supports against the generic one (also those that INTEGER_KERNELS
+	would not pick), over lengths around the unrolling and the vector widths
+*/
+void test_kernels() {
+	typedef Integer::limb limb;
+	const LimbKernels& generic = *find_limb_kernels("generic");
+	std::mt19937_64 random(29);
+	for (const char* name : { "bmi2", "adx", "avx2", "avx512" }) {
+		const LimbKernels* kernels = find_limb_kernels(name);
+		if (kernels == nullptr) { // not supported by this CPU
+			continue;
+		}
+		for (std::size_t n = 0; n <= 40; ++n) {
+			std::vector<limb> a(n), b(n), r(n), expected(n);
+			for (std::size_t i = 0; i < n; ++i) {
+				a[i] = random() % 4 == 0 ? ~(limb)0 : random();
+				b[i] = random() % 4 == 0 ? ~(limb)0 : random();
+				r[i] = random();
+			}
+			limb y = random() % 3 == 0 ? ~(limb)0 : random();
+			std::string what = std::string(name) + " n = " + std::to_string(n);
+
+			check(kernels->add_n(r.data(), a.data(), b.data(), n) == generic.add_n(expected.data(), a.data(), b.data(), n)
+				&& r == expected, what + " add_n");
+			check(kernels->sub_n(r.data(), a.data(), b.data(), n) == generic.sub_n(expected.data(), a.data(), b.data(), n)
+				&& r == expected, what + " sub_n");
+			check(kernels->mul_1(r.data(), a.data(), n, y) == generic.mul_1(expected.data(), a.data(), n, y)
+				&& r == expected, what + " mul_1");
+			r = expected = b;
+			check(kernels->addmul_1(r.data(), a.data(), n, y) == generic.addmul_1(expected.data(), a.data(), n, y)
+				&& r == expected, what + " addmul_1");
+			r = expected = b;
+			check(kernels->submul_1(r.data(), a.data(), n, y) == generic.submul_1(expected.data(), a.data(), n, y)
+				&& r == expected, what + " submul_1");
+			kernels->and_n(r.data(), a.data(), b.data(), n);
+			generic.and_n(expected.data(), a.data(), b.data(), n);
+			check(r == expected, what + " and_n");
+			kernels->or_n(r.data(), a.data(), b.data(), n);
+			generic.or_n(expected.data(), a.data(), b.data(), n);
+			check(r == expected, what + " or_n");
+			kernels->xor_n(r.data(), a.data(), b.data(), n);
+			generic.xor_n(expected.data(), a.data(), b.data(), n);
+			check(r == expected, what + " xor_n");
+		}
+	}
+}
+
+}
+
+/** Returns a random Integer of n limbs (fewer if the top limbs are zero), with runs of all-ones and zero
+	limbs that make the carries of the products long
+	@param random generator
+	@param n number of limbs
+	@return value, negative with probability 1/2
+*/
+Integer random_integer(std::mt19937_64& random, std::size_t n) {
+	std::vector<Integer::limb> limbs(n);
+	for (Integer::limb& limb : limbs) {
+		int kind = random() % 8;
+		limb = kind == 0 ? 0 : kind == 1 ? ~(Integer::limb)0 : random();
+	}
+	return Integer::from_limbs(limbs.data(), n, random() % 2 == 1);
+}
+
+/** Returns x*y by schoolbook multiplication, one limb of y at a time (addmul_limb only: no Karatsuba or transform)
+*/
+Integer schoolbook(const Integer& x, const Integer& y) {
+	Integer product = 0;
+	for (std::size_t j = y.size(); j-- > 0; ) {
+		product <<= 64;
+		addmul_limb(product, x, y.limbs()[j]);
+	}
+	return y.negative() ? -product : product;
+}
+
+/** Products, squares and fused multiply-adds against schoolbook multiplication, with the Karatsuba and transform
+	thresholds lowered so that small operands already take the recursive and transform paths (and their
+	unbalanced and odd-sized splits)
+*/
+void test_products() {
+	std::mt19937_64 random(36);
+	const std::size_t thresholds[][2] = { { 2, 2 }, { 4, 8 }, { 24, 64 } }; // Karatsuba, transforms
+	for (const std::size_t* threshold : thresholds) {
+		set_karatsuba_threshold(threshold[0]);
+		set_ntt_threshold(threshold[1]);
+		std::string setting = " (thresholds " + std::to_string(threshold[0]) + "/" + std::to_string(threshold[1]) + ")";
+		for (int trial = 0; trial < 1000; ++trial) {
+			bool large = trial % 50 == 0; // up to 60000 bits; the others up to 2000 bits
+			std::size_t max_limbs = large ? 938 : 32;
+			Integer x = random_integer(random, 1 + random() % max_limbs);
+			Integer y = random_integer(random, 1 + (trial % 3 == 0 ? random() % 4 : random() % max_limbs)); // often unbalanced
+			std::string what = " trial " + std::to_string(trial) + setting;
+
+			Integer expected = schoolbook(x, y);
+			check(Integer(x * y) == expected && Integer(y * x) == expected, "product" + what);
+			Integer z = x;
+			z *= y;
+			check(z == expected, "*=" + what);
+			Integer acc = y;
+			addmul(acc, x, y);
+			check(acc == expected + y, "addmul" + what);
+
+			expected = schoolbook(x, x);
+			check(Integer(x * x) == expected, "square" + what);
+			z = x;
+			z *= z;
+			check(z == expected, "*= itself" + what);
+		}
+	}
+	set_karatsuba_threshold(0);
+	set_ntt_threshold(0);
+}
+
+/** stirling1_row and stirling2_row (product trees and Kronecker substitution) against the recurrences of
+	Table.h, column by column, also with lowered product thresholds
+*/
+void test_stirling_rows() {
+	const std::size_t thresholds[][2] = { { 0, 0 }, { 2, 2 } }; // defaults, then every path
+	for (const std::size_t* threshold : thresholds) {
+		set_karatsuba_threshold(threshold[0]);
+		set_ntt_threshold(threshold[1]);
+		std::vector<Integer> s(1, Integer(1)), S(1, Integer(1)); // s(k, 0) and S(k, 0): 1 for k = 0
+		for (int n = 0; n <= 160; ++n) {
+			if (n > 0) { // s(k, n) = -(n-1) s(k, n-1) + s(k-1, n-1); S(k, n) = kS(k, n-1) + S(k-1, n-1)
+				std::vector<Integer> s_next(n + 1), S_next(n + 1);
+				for (int k = 1; k <= n; ++k) {
+					s_next[k] = s[k - 1];
+					S_next[k] = S[k - 1];
+					if (k < n) {
+						submul_limb(s_next[k], s[k], n - 1);
+						addmul_limb(S_next[k], S[k], k);
+					}
+				}
+				s.swap(s_next);
+				S.swap(S_next);
+			}
+			if (n <= 40 || n % 30 == 0) {
+				std::string what = " n = " + std::to_string(n) + " (thresholds " + std::to_string(karatsuba_threshold()) + "/"
+					+ std::to_string(ntt_threshold()) + ")";
+				check(stirling1_row(n) == s, "stirling1_row" + what);
+				check(stirling2_row(n) == S, "stirling2_row" + what);
+			}
+		}
+	}
+	set_karatsuba_threshold(0);
+	set_ntt_threshold(0);
+}
+
+/** partition_number (Rademacher series) against partition_numbers (pentagonal number recurrence), around the
+	crossover from the recurrence to the series (n = 100) and up to n = 20000, and a few published values
+*/
+void test_partitions() {
+	IntegerTable pentagonal = partition_numbers(20000);
+	for (int n : { 0, 1, 2, 3, 10, 98, 99, 100, 101, 102, 150, 1234, 5000, 20000 }) {
+		check(partition_number(n) == pentagonal[(std::size_t)n].to_integer(), "partition_number(" + std::to_string(n) + ")");
+	}
+	check(partition_number(-1) == 0, "partition_number(-1)");
+
+	const std::pair<int, const char*> published[] = { { 10, "42" }, { 100, "190569292" },
+		{ 1000, "24061467864032622473692149727991" } };
+	for (const std::pair<int, const char*>& value : published) {
+		std::ostringstream text;
+		text << pentagonal[(std::size_t)value.first];
+		check(text.str() == value.second, "p(" + std::to_string(value.first) + ") = " + value.second);
+	}
+}
+
+#ifdef INTEGER_EXPRESSION_TEMPLATES
+/** Returns a copy of x, as an expiring operand
+*/
+Integer expiring(const Integer& x) {
+	return x;
+}
+
+/** Expression trees (IntegerExpr.h) against the same values computed with the compound operators: trees that
+	mix lvalues, expiring values and integral scalars of several types, trees whose result is one of their own
+	operands, and nested negations
+*/
+void test_expressions() {
+	std::mt19937_64 random(27);
+	for (int trial = 0; trial < 500; ++trial) {
+		Integer a = 0, b = 0, c = 0;
+		for (Integer* x : { &a, &b, &c }) {
+			for (int i = random() % 4; i > 0; --i) {
+				*x <<= 64;
+				*x += (int)(random() >> 33);
+			}
+			if (random() % 2) {
+				*x = -*x;
+			}
+		}
+		std::string what = " trial " + std::to_string(trial);
+		Integer ab = a, expected;
+		ab *= b;
+
+		expected = ab; // a*b + c - 3*(a - b)
+		Integer difference = a;
+		difference -= b;
+		difference *= 3;
+		expected += c;
+		expected -= difference;
+		check(Integer(a * b + c - 3 * (a - b)) == expected, "expr: mixed tree" + what);
+		check(Integer(expiring(a) * b + expiring(c) - 3 * (expiring(a) - b)) == expected, "expr: expiring leaves" + what);
+		check(a * b + c - 3 * (a - b) == expected && expected == a * b + c - 3 * (a - b), "expr: comparison of a tree" + what);
+
+		expected = ab; // -(-(a*b) + c) and -(-(a - b))
+		expected -= c;
+		check(Integer(-(-(a * b) + c)) == expected, "expr: nested negation of a sum" + what);
+		check(Integer(-(-(expiring(a) * b) + expiring(c))) == expected, "expr: nested negation, expiring" + what);
+		difference = a;
+		difference -= b;
+		check(Integer(-(-(a - b))) == difference && Integer(-(-(expiring(a) - b))) == difference, "expr: double negation" + what);
+
+		Integer x = a; // x = x*b + x
+		expected = ab;
+		expected += a;
+		x = x * b + x;
+		check(x == expected, "expr: x = x*b + x" + what);
+		x = a; // x = c - x*x
+		expected = c;
+		Integer square = a;
+		square *= a;
+		expected -= square;
+		x = c - x * x;
+		check(x == expected, "expr: x = c - x*x" + what);
+		x = a; // x = -(x - b)*x
+		expected = b;
+		expected -= a;
+		expected *= a;
+		x = -(x - b) * x;
+		check(x == expected, "expr: x = -(x - b)*x" + what);
+	}
+
+	// Integral operands of other types than int are converted exactly
+	Integer a = 1;
+	a <<= 70;
+	Integer expected = a, big = Integer::from_limb((Integer::limb)1 << 63);
+	expected -= big;
+	check(a + LLONG_MIN == expected && Integer(LLONG_MIN + a) == expected, "expr: long long minimum");
+	expected = a;
+	expected += Integer::from_limb(ULLONG_MAX);
+	check(a + ULLONG_MAX == expected && Integer(ULONG_MAX + a) == expected, "expr: unsigned long maximum");
+	expected = a;
+	expected *= Integer::from_limb((Integer::limb)5000000000);
+	check(Integer(a * (std::size_t)5000000000) == expected && Integer(5000000000L * a) == expected, "expr: std::size_t and long factors");
+	expected = a;
+	expected -= 7;
+	check(Integer(a - 7u) == expected && Integer(a + (short)-7) == expected && a - 7ul == expected, "expr: unsigned and short operands");
+	check(a * 0L + 3u == 3 && 3 == a * 0L + 3u && !(a - 1u < 0) && (a * -1L < 0), "expr: comparisons with integral values");
+}
+#endif
+
+#ifdef INTEGER_COW
+/** Copy-on-write storage (IntegerCow.h): copies share a block until one of them changes, and a change never
+	reaches the other copies, including copies made and destroyed concurrently on another thread
+*/
+void test_cow() {
+	typedef Integer::storage Storage;
+	Integer original = 1;
+	original <<= 1000;
+	original -= 12345;
+	const Integer expected = Integer(1) * original; // computed, so it has its own block
+
+	Integer copy = original; // mutating a copy leaves the original unchanged
+	copy += 1;
+	check(original == expected && copy == expected + 1, "cow: += on a copy");
+	copy = original;
+	copy <<= 3;
+	check(original == expected && copy == expected * 8, "cow: <<= on a copy");
+	copy = original;
+	addmul_limb(copy, copy, 3);
+	check(original == expected && copy == expected * 4, "cow: addmul_limb on a copy");
+	copy = original;
+	copy.copy_from(original);
+	copy.mul_limb(5);
+	check(original == expected && copy == expected * 5, "cow: copy_from, then mul_limb");
+
+	Storage a(4, (Integer::limb)7), b = a;
+	const Storage& a_read = a; // const access, which never detaches
+	check(a.use_count() == 2 && a_read.data() == static_cast<const Storage&>(b).data(), "cow: a copy shares the block");
+	b[0] = 1;
+	check(a.use_count() == 1 && b.use_count() == 1 && a[0] == 7 && b[0] == 1, "cow: a write detaches the copy");
+	Storage c;
+	c.assign(a.begin(), a.end());
+	check(a.use_count() == 1 && c == a, "cow: assign copies the elements");
+
+	Storage& self = a; // self-assignment
+	a = self;
+	check(a.use_count() == 1 && a.size() == 4 && a[3] == 7, "cow: self copy assignment");
+	a = std::move(self);
+	check(a.use_count() == 1 && a.size() == 4 && a[3] == 7, "cow: self move assignment");
+	copy = original;
+	copy = static_cast<const Integer&>(copy);
+	check(copy == expected, "cow: Integer self assignment");
+
+	b = a; // move from a shared block: the moved-to storage takes the reference, the other copy keeps it
+	Storage moved = std::move(b);
+	check(b.empty() && b.use_count() == 0 && moved.use_count() == 2 && moved == a, "cow: move from a shared block");
+	moved.push_back(9);
+	check(a.size() == 4 && moved.size() == 5 && a.use_count() == 1, "cow: write after a move from a shared block");
+
+	// Two threads copy, change and destroy copies of one shared value: the count must end at one reference
+	std::shared_ptr<const Integer> shared = std::make_shared<const Integer>(original);
+	auto churn = [shared, &expected](int seed) {
+		bool passed = true;
+		for (int i = 0; i < 20000; ++i) {
+			Integer local = *shared;
+			if ((i + seed) % 4 == 0) {
+				local += seed;
+				passed = passed && local == expected + seed;
+			}
+			passed = passed && *shared == expected;
+		}
+		return passed;
+	};
+	bool passed[2];
+	std::thread other([&] { passed[1] = churn(2); });
+	passed[0] = churn(1);
+	other.join();
+	Integer last = *shared;
+	last -= 1;
+	check(passed[0] && passed[1] && *shared == expected && last == expected - 1, "cow: concurrent copies");
+}
+#endif
+
+/** Runs every check
+	@return 0 if they all pass, 1 otherwise
+*/
+int main() {
+	test_aliasing();
+	test_mul_limb();
+	test_decimal();
+	test_kernels();
+	test_products();
+	test_stirling_rows();
+	test_partitions();
+#ifdef INTEGER_EXPRESSION_TEMPLATES
+	test_expressions();
+#endif
+#ifdef INTEGER_COW
+	test_cow();
+#endif
+	if (failures == 0) {
+		std::cout << "All checks passed" << std::endl;
+	}
+	return failures == 0 ? 0 : 1;
+}